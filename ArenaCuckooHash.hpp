@@ -0,0 +1,1044 @@
+/*
+    Data Structures
+    Project Hash: Cuckoo Hashing
+    Author: Anthony Lupica <arl127@uakron.edu> 2022
+
+    Header file for ArenaCuckooHash, a CuckooHash for string keys that keeps the key bytes out of the slots.
+
+    CuckooHash<std::string, Value> stores a 32-byte std::string in every slot, and every key longer
+    than the string's inline buffer is a separate heap block that a lookup has to chase. Here the
+    bytes of all keys are appended to one contiguous arena, and a slot holds only an 8-bit fingerprint,
+    an 8-byte KeyRef (offset and length of the key within the arena) and the value. For an int value
+    that is 13 bytes per slot, against 41 for CuckooHash<std::string, int>, plus the key's bytes
+    once in the arena.
+
+    Ex.] Birth Year
+    ArenaCuckooHash<int> birthYears;
+    birthYears.insert("Brad Pitt", 1963);
+    std::cout << *birthYears.search("Brad Pitt");
+        --> "1963"
+
+    Keys are passed and compared as std::string_view, so neither insert() nor a lookup builds a
+    std::string. Which slots hold a record is kept in a per-bucket occupancy bitmap, so every tag value
+    (including 0) is a valid fingerprint. Table positions, fingerprints, the bucket layout and the
+    breadth-first displacement search are those of CuckooHash. There is no stash and no incremental resize:
+    a key without a displacement path grows the tables.
+
+    The arena is append-only. remove() leaves the key's bytes behind, and once more than half of the
+    arena is such dead bytes (and it is at least ARENA_COMPACT_BYTES long) the live keys are copied into
+    a fresh arena. Moving a record between slots, or into grown tables, never touches its key bytes.
+
+    Nothing in the tables or the arena is a pointer, so with a trivially copyable Value the whole table
+    can be written out as it is. save() writes a snapshot: a versioned SnapshotHeader (sizes, record count,
+    the Hasher's seed), both tables and the arena. open_mmap() maps such a file read-only and serves
+    search() and contains() straight from the mapped pages, with nothing to deserialize, so processes
+    opening one snapshot share its page cache. Opening reads the tables once (not the arena) to check
+    that every KeyRef lies within the arena and that the record count matches, so a corrupt snapshot is
+    refused rather than read out of bounds.
+    Lookups never copy: only the first insert(), remove() or search_mutable() on a mapped table copies
+    it into memory of its own.
+
+    Ex.] Restart
+    birthYears.save("birthYears.snapshot");
+    ...
+    ArenaCuckooHash<int> restored;
+    restored.open_mmap("birthYears.snapshot");
+    std::cout << *restored.search("Brad Pitt");
+*/
+
+#ifndef ARENACUCKOOHASH_HPP_INCLUDED
+#define ARENACUCKOOHASH_HPP_INCLUDED
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <initializer_list>
+#include <iostream>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "CuckooHash.hpp"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace cuckoo
+{
+    // widths of a KeyRef's fields: keys up to 16 MiB long, in an arena of up to 1 TiB
+    const unsigned ARENA_LENGTH_BITS = 24;
+    const unsigned ARENA_OFFSET_BITS = 40;
+
+    // smallest arena remove() compacts. Below it, dead key bytes cost less than copying the live ones
+    const std::size_t ARENA_COMPACT_BYTES = 1 << 16;
+
+    // first bytes of a snapshot file, and the format version save() writes. A snapshot of another
+    // version is refused rather than converted
+    constexpr char SNAPSHOT_MAGIC[8] = { 'C', 'U', 'C', 'K', 'O', 'O', 'S', 'N' };
+    const std::uint32_t SNAPSHOT_VERSION = 1;
+
+    /* mapFile()
+    *
+    *  maps the whole file at path read-only and returns its address (nullptr on failure), with its
+    *  length in bytes
+    */
+    inline const unsigned char *mapFile(const std::string &path, std::size_t &bytes)
+    {
+#if defined(_WIN32)
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return nullptr;
+        }
+
+        LARGE_INTEGER size;
+        HANDLE mapping = GetFileSizeEx(file, &size) && size.QuadPart > 0 ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+        void *address = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (mapping != nullptr)
+        {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+
+        bytes = address != nullptr ? static_cast<std::size_t>(size.QuadPart) : 0;
+        return static_cast<const unsigned char *>(address);
+#else
+        int file = ::open(path.c_str(), O_RDONLY);
+        if (file == -1)
+        {
+            return nullptr;
+        }
+
+        struct stat status;
+        void *address = MAP_FAILED;
+        if (::fstat(file, &status) == 0 && status.st_size > 0)
+        {
+            address = ::mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_SHARED, file, 0);
+        }
+        ::close(file);
+
+        if (address == MAP_FAILED)
+        {
+            return nullptr;
+        }
+
+        bytes = static_cast<std::size_t>(status.st_size);
+        return static_cast<const unsigned char *>(address);
+#endif
+    }
+
+    /* unmapFile()
+    *
+    *  releases a mapping made by mapFile()
+    */
+    inline void unmapFile(const unsigned char *address, std::size_t bytes)
+    {
+#if defined(_WIN32)
+        (void)bytes;
+        UnmapViewOfFile(address);
+#else
+        ::munmap(const_cast<unsigned char *>(address), bytes);
+#endif
+    }
+}
+
+template <typename Value, typename Hasher = cuckoo::StringHash, std::size_t SlotsPerBucket = 4>
+class ArenaCuckooHash
+{
+    static_assert(SlotsPerBucket >= 1 && SlotsPerBucket <= 32, "SlotsPerBucket must be between 1 and 32");
+
+    private:
+
+        // where a key's bytes lie within the arena
+        struct KeyRef
+        {
+            std::uint64_t offset : cuckoo::ARENA_OFFSET_BITS; // first byte of the key
+            std::uint64_t length : cuckoo::ARENA_LENGTH_BITS; // key length in bytes
+        };
+
+        static_assert(sizeof(KeyRef) == 8, "a KeyRef must pack into 8 bytes");
+
+        // one hash position: the occupancy bitmap and the tags come first, so a probe decides which keys
+        // are worth comparing from the bucket's first bytes. A zeroed bucket has no occupied slot, so
+        // tables are allocated as zeroed memory as in CuckooHash
+        struct alignas(SlotsPerBucket > 1 ? cuckoo::CACHE_LINE : alignof(KeyRef)) Bucket
+        {
+            std::uint32_t occupied;                                           // bit s is set while slot s holds a record
+            std::uint8_t tags[SlotsPerBucket];                                // fingerprint of each occupied slot
+            KeyRef keys[SlotsPerBucket];                                      // the key of each occupied slot
+            alignas(Value) unsigned char values[SlotsPerBucket][sizeof(Value)]; // the value of each occupied slot
+
+            Value &value(std::size_t slot)
+            { return *std::launder(reinterpret_cast<Value *>(values[slot])); }
+            const Value &value(std::size_t slot) const
+            { return *std::launder(reinterpret_cast<const Value *>(values[slot])); }
+        };
+
+        // one bucket visited by the displacement path search (see CuckooHash::PathNode)
+        struct PathNode
+        {
+            std::size_t bucket; // bucket index within its table
+            std::size_t parent; // node whose record moves into this bucket (NO_PARENT for the key's own buckets)
+            std::size_t depth;  // number of moves from the key's own bucket to this one
+            int table;          // 1 or 2
+            int slot;           // slot of the parent bucket holding the record that moves here
+        };
+
+        static constexpr std::size_t NO_PARENT = static_cast<std::size_t>(-1);
+
+        // the start of a snapshot file, followed by table 1, table 2 and the arena. Every field a reader
+        // needs to reject a snapshot of another table type (or of another byte order) is checked by open_mmap()
+        struct alignas(cuckoo::CACHE_LINE) SnapshotHeader
+        {
+            char magic[8];              // SNAPSHOT_MAGIC
+            std::uint32_t version;      // SNAPSHOT_VERSION
+            std::uint32_t byteOrder;    // 0x01020304 as written by the saving machine
+            std::uint64_t slots;        // SlotsPerBucket
+            std::uint64_t bucketBytes;  // sizeof(Bucket)
+            std::uint64_t valueBytes;   // sizeof(Value)
+            std::uint64_t tableSize;    // buckets per table
+            std::uint64_t records;      // size()
+            std::uint64_t arenaBytes;   // arena length, dead bytes included
+            std::uint64_t deadBytes;    // dead arena bytes
+            std::uint64_t seed;         // the Hasher's seed (0 for a Hasher without one)
+            std::uint64_t hashCheck;    // hash code of SNAPSHOT_CHECK_KEY, which catches any other Hasher difference
+        };
+
+        static constexpr std::string_view SNAPSHOT_CHECK_KEY = "cuckoo snapshot";
+
+        // same bounds as a CuckooHash of two tables
+        static constexpr std::size_t MAX_PATH_LENGTH = cuckoo::maxPathLength(SlotsPerBucket, 2);
+        static constexpr double MAX_LOAD_FACTOR = cuckoo::maxLoadFactor(SlotsPerBucket, 2);
+
+        // private data members
+        std::size_t tableSize;           // number of buckets per table (grows by GROWTH_FACTOR on rehash)
+        Bucket *table1;                  // the primary hash table
+        Bucket *table2;                  // the secondary "eviction" table
+        std::size_t nodeCount;           // number of records in both tables
+        std::vector<char> arena;         // the bytes of every key, in insertion order
+        std::size_t deadBytes;           // arena bytes of removed keys
+        const char *keyData;             // the first arena byte: arena.data(), or within the mapping
+        const unsigned char *mapping;    // the snapshot open_mmap() serves from (nullptr when the table owns its memory)
+        std::size_t mappingBytes;        // length of the mapping
+        std::vector<PathNode> pathQueue; // the displacement path search's queue, kept to reuse its memory
+        Hasher hasher;                   // hash function object, evaluated once per operation by hashOf()
+
+        // private methods
+        std::uint64_t hashOf(std::string_view key) const;                        // the 64-bit hash code all positions derive from
+        std::string_view keyOf(KeyRef ref) const                                 // the arena bytes a KeyRef points to
+        { return std::string_view(keyData + ref.offset, ref.length); }
+        int findSlot(const Bucket &bucket, std::string_view key, std::uint8_t tag) const; // slot holding key within bucket, or -1
+        template <typename V>
+        void insertRecord(std::string_view key, V &&value);                      // shared body of the insert() overloads
+        bool placeInTables(KeyRef ref, Value &value, std::uint8_t tag, std::uint64_t hashCode); // seats a record known to be absent, false when no path was found
+        std::size_t findPath(std::uint64_t hashCode, int &slot);                 // breadth-first search for a free slot reachable by displacements
+        bool onPath(std::size_t node, int table, std::size_t bucket) const;      // true when a bucket already lies on the path to node
+        Bucket *tableOf(int whichTable) const                                    // table 1 or 2
+        { return whichTable == 1 ? table1 : table2; }
+        bool rehash(std::size_t newTableSize);                                   // moves every record into tables of newTableSize buckets (or larger)
+        bool moveValues(Bucket *table, std::size_t size);                        // moves the values of a replaced table into the current tables, false when one has no path
+        void returnValues(Bucket *table, std::size_t size);                      // moves the values of an abandoned table back to their slots in the current tables
+        void compact();                                                          // copies the live keys into a fresh arena
+        void detach();                                                           // copies a mapped snapshot into memory of the table's own
+        void release();                                                          // frees (or unmaps) the tables
+        std::int64_t position(std::string_view key, std::uint64_t hashCode, int &whichTable, int &slot) const; // the bucket of a found record, or -1
+        static int freeSlot(const Bucket &bucket);                               // first free slot within bucket, or -1
+        static bool validTables(const SnapshotHeader &header, const Bucket *tables); // true if the mapped tables agree with the header
+        static Bucket *allocateTable(std::size_t size);                          // size empty buckets of zeroed memory
+        static void freeTable(Bucket *table, std::size_t size);                  // destroys the values of a table and frees it
+
+    public:
+
+        // ctors and dtor
+        ArenaCuckooHash();                                         // default constructor
+        ArenaCuckooHash(const ArenaCuckooHash &) = delete;         // tables are owned, copying is not supported
+        ArenaCuckooHash &operator=(const ArenaCuckooHash &) = delete;
+        ~ArenaCuckooHash();                                        // destructor
+
+        // public methods
+        void insert(std::string_view key, const Value &value)      // insert into the hash table
+        { insertRecord(key, value); }
+        void insert(std::string_view key, Value &&value)           // insert overload moving the value in
+        { insertRecord(key, std::move(value)); }
+        const Value *search(std::string_view key) const;           // search the hash table for a record (nullptr if absent)
+        Value *search_mutable(std::string_view key)                // search() granting write access to the value, which copies a mapped snapshot into memory first
+        { detach(); return const_cast<Value *>(search(key)); }
+        void remove(std::string_view key);                         // remove a record from the hash table
+        bool contains(std::string_view key) const                  // find if the hash table contains a record
+        { int whichTable = -1, slot = -1; return position(key, hashOf(key), whichTable, slot) != -1; }
+        std::size_t size() const                                   // getter for the number of records
+        { return nodeCount; }
+        void display() const;                                      // display the hash table (requires operator<< for Value)
+        std::size_t capacity() const                               // getter for the number of buckets per table
+        { return tableSize; }
+        void reserve(std::size_t count);                           // pre-size the tables so that count records fit without a rehash
+        double load_factor() const                                 // fraction of all slots (both tables) holding a record
+        { return static_cast<double>(nodeCount) / (2.0 * tableSize * SlotsPerBucket); }
+        std::size_t arena_bytes() const;                           // getter for the arena length, dead bytes included
+        std::size_t memory_bytes() const                           // bytes held by the tables and the arena (or mapped)
+        { return mapping != nullptr ? mappingBytes : 2 * tableSize * sizeof(Bucket) + arena.capacity(); }
+        bool save(const std::string &path) const;                  // write a snapshot of the table to path, false on failure
+        bool open_mmap(const std::string &path);                   // replace the table by a read-only mapping of a snapshot, false on failure
+        bool mapped() const                                        // true while the table is served from a snapshot mapping
+        { return mapping != nullptr; }
+};
+
+/* Default Constructor
+*
+*  Initialize table size to INITIAL_TABLE_SIZE, with an empty arena.
+*/
+template <typename Value, typename Hasher, std::size_t SlotsPerBucket>
+ArenaCuckooHash<Value, Hasher, SlotsPerBucket>::ArenaCuckooHash()
+    : tableSize(cuckoo::INITIAL_TABLE_SIZE), nodeCount(0), deadBytes(0), keyData(nullptr), mapping(nullptr), mappingBytes(0)
+{
+    table1 = allocateTable(tableSize);
+    table2 = allocateTable(tableSize);
+}
+
+/* ~Destructor()
+*
+*  Destructs both hash tables (or unmaps a snapshot). The arena frees itself.
+*/
+template <typename Value, typename Hasher, std::size_t SlotsPerBucket>
+ArenaCuckooHash<Value, Hasher, SlotsPerBucket>::~ArenaCuckooHash()
+{
+    release();
+}
+
+/* insertRecord()
+*
+*  body of the insert() overloads. If the given key is unique, its bytes are appended to the arena
+*  and the record is seated as CuckooHash::insert() seats it: in a free slot of either bucket, else at
+*  the start of a displacement path, else after growing the tables.
+*/
+template <typename Value, typename Hasher, std::size_t SlotsPerBucket>
+template <typename V>
+void ArenaCuckooHash<Value, Hasher, SlotsPerBucket>::insertRecord(std::string_view key, V &&value)
+{
+    detach();
+
+    std::uint64_t hashCode = hashOf(key);
+    std::uint8_t tag = static_cast<std::uint8_t>(hashCode);
+
+    int whichTable = -1;
+    int slot = -1;
+    if (position(key, hashCode, whichTable, slot) != -1)
+    {
+        std::cerr << "key already exists within the hash table\n";
+
+        return;
+    }
+
+    if (key.size() >= (std::uint64_t(1) << cuckoo::ARENA_LENGTH_BITS)
+        || arena.size() + key.size() > (std::uint64_t(1) << cuckoo::ARENA_OFFSET_BITS))
+    {
+        std::cerr << "key does not fit in the key arena\n";
+
+        return;
+    }
+
+    if (load_factor() >= MAX_LOAD_FACTOR && rehash(tableSize * cuckoo::GROWTH_FACTOR) == 1)
+    {
+        return;
+    }
+
+    KeyRef ref;
+    ref.offset = arena.size();
+    ref.length = key.size();
+    arena.insert(arena.end(), key.begin(), key.end());
+    keyData = arena.data();
+
+    Value newValue(std::forward<V>(value));
+    while (!placeInTables(ref, newValue, tag, hashCode))
+    {
+        if (rehash(tableSize * cuckoo::GROWTH_FACTOR) == 1)
+        {
+            // the key never made it into the tables
+            deadBytes += ref.length;
+
+            return;
+        }
+    }
+}
+
+/* placeInTables()
+*
+*  seats a record in a free slot of its table 1 bucket, else of its table 2 bucket, else at the start
+*  of a displacement path found by findPath(), shifting the records on the path as CuckooHash does.
+*  Only KeyRefs move, never key bytes. Returns false, leaving value untouched, when there is no path.
+*/
+template <typename Value, typename Hasher, std::size_t SlotsPerBucket>
+bool ArenaCuckooHash<Value, Hasher, SlotsPerBucket>::placeInTables(KeyRef ref, Value &value, std::uint8_t tag, std::uint64_t hashCode)
+{
+    int slot = -1;
+    std::size_t node = findPath(hashCode, slot);
+    if (node == NO_PARENT)
+    {
+        return false;
+    }
+
+    // walk the path back from its free slot, moving each record one bucket forward
+    while (pathQueue[node].parent != NO_PARENT)
+    {
+        const PathNode &to = pathQueue[node];
+        const PathNode &from = pathQueue[to.parent];
+        Bucket &source = tableOf(from.table)[from.bucket];
+        Bucket &target = tableOf(to.table)[to.bucket];
+
+        new (target.values[slot]) Value(std::move(source.value(to.slot)));
+        target.keys[slot] = source.keys[to.slot];
+        target.tags[slot] = source.tags[to.slot];
+        target.occupied |= std::uint32_t(1) << slot;
+        source.value(to.slot).~Value();
+        source.occupied &= ~(std::uint32_t(1) << to.slot);
+
+        slot = to.slot;
+        node = to.parent;
+    }
+
+    Bucket &home = tableOf(pathQueue[node].table)[pathQueue[node].bucket];
+    new (home.values[slot]) Value(std::move(value));
+    home.keys[slot] = ref;
+    home.tags[slot] = tag;
+    home.occupied |= std::uint32_t(1) << slot;
+    ++nodeCount;
+
+    return true;
+}
+
+/* findPath()
+*
+*  breadth-first search from the key's two buckets for a bucket with a free slot, as in CuckooHash.
+*  The alternate bucket of an occupant comes from rehashing its key straight from the arena.
+*  Returns the node of the bucket with the free slot (and the free slot in slot), or NO_PARENT.
+*/
+template <typename Value, typename Hasher, std::size_t SlotsPerBucket>
+std::size_t ArenaCuckooHash<Value, Hasher, SlotsPerBucket>::findPath(std::uint64_t hashCode, int &slot)
+{
+    pathQueue.clear();
+    pathQueue.push_back(PathNode{ cuckoo::hash1(hashCode, tableSize), NO_PARENT, 0, 1, -1 });
+    pathQueue.push_back(PathNode{ cuckoo::hash2(hashCode, tableSize), NO_PARENT, 0, 2, -1 });
+
+    for (std::size_t head = 0; head < pathQueue.size(); ++head)
+    {
+        PathNode current = pathQueue[head];
+        const Bucket &bucket = tableOf(current.table)[current.bucket];
+
+        slot = freeSlot(bucket);
+        if (slot != -1)
+        {
+            return head;
+        }
+
+        if (current.depth >= MAX_PATH_LENGTH)
+        {
+            continue;
+        }
+
+        // every record of a full bucket could move to its bucket in the other table
+        for (std::size_t s = 0; s < SlotsPerBucket && pathQueue.size() < cuckoo::MAX_SEARCH_BUCKETS; ++s)
+        {
+            std::uint64_t occupantHash = hashOf(keyOf(bucket.keys[s]));
+            int otherTable = current.table == 1 ? 2 : 1;
+            std::size_t otherBucket = otherTable == 1 ? cuckoo::hash1(occupantHash, tableSize) : cuckoo::hash2(occupantHash, tableSize);
+
+            if (!onPath(head, otherTable, otherBucket))
+            {
+                pathQueue.push_back(PathNode{ otherBucket, head, current.depth + 1, otherTable, static_cast<int>(s) });
+            }
+        }
+    }
+
+    return NO_PARENT;
+}
+
+/* onPath()
+*
+*  returns true if the bucket is node's own bucket or one of the buckets on the path leading to it
+*/
+template <typename Value, typename Hasher, std::size_t SlotsPerBucket>
+bool ArenaCuckooHash<Value, Hasher, SlotsPerBucket>::onPath(std::size_t node, int table, std::size_t bucket) const
+{
+    for (; node != NO_PARENT; node = pathQueue[node].parent)
+    {
+        if (pathQueue[node].table == table && pathQueue[node].bucket == bucket)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* search()
+*
+*  looks in the key's table 1 bucket, then in its table 2 bucket. If found, a pointer to the value
+*  is returned, and nullptr otherwise.
+*/
+template <typename Value, typename Hasher, std::size_t SlotsPerBucket>
+const Value *ArenaCuckooHash<Value, Hasher, SlotsPerBucket>::search(std::string_view key) const
+{
+    int whichTable = -1;
+    int slot = -1;
+    std::int64_t index = position(key, hashOf(key), whichTable, slot);
+
+    if (index == -1)
+    {
+        return nullptr;
+    }
+
+    return &tableOf(whichTable)[index].value(slot);
+}
+
+/* remove()
+*
+*  deletes the record if it exists. Its key bytes stay in the arena until the next compaction.
+*/
+template <typename Value, typename Hasher, std::size_t SlotsPerBucket>
+void ArenaCuckooHash<Value, Hasher, SlotsPerBucket>::remove(std::string_view key)
+{
+    detach();
+
+    int whichTable = -1;
+    int slot = -1;
+    std::int64_t index = position(key, hashOf(key), whichTable, slot);
+
+    if (index == -1)
+    {
+        std::cerr << "key does not exist within the table\n";
+
+        return;
+    }
+
+    Bucket &bucket = tableOf(whichTable)[index];
+    bucket.value(slot).~Value();
+    bucket.occupied &= ~(std::uint32_t(1) << slot);
+    deadBytes += bucket.keys[slot].length;
+    --nodeCount;
+
+    if (deadBytes * 2 > arena.size() && arena.size() >= cuckoo::ARENA_COMPACT_BYTES)
+    {
+        compact();
+    }
+}
+
+/* reserve()
+*
+*  grows the tables once so that count records fit without reaching MAX_LOAD_FACTOR
+*/
+template <typename Value, typename Hasher, std::size_t SlotsPerBucket>
+void ArenaCuckooHash<Value, Hasher, SlotsPerBucket>::reserve(std::size_t count)
+{
+    std::size_t neededSize = static_cast<std::size_t>(std::ceil(count / (MAX_LOAD_FACTOR * 2 * SlotsPerBucket))) + 1;
+
+    if (neededSize > tableSize)
+    {
+        detach();
+        rehash(neededSize);
+    }
+}
+
+/* hashOf
+*
+*  the one hash computation of an operation, finalized with cuckoo::mixInt() unless the Hasher is
+*  avalanching (see CuckooHash::hashOf())
+*/
+template <typename Value, typename Hasher, std::size_t SlotsPerBucket>
+std::uint64_t ArenaCuckooHash<Value, Hasher, SlotsPerBucket>::hashOf(std::string_view key) const
+{
+    if constexpr (cuckoo::is_avalanching<Hasher>::value)
+    {
+        return static_cast<std::uint64_t>(hasher(key));
+    }
+    else
+    {
+        return cuckoo::mixInt(static_cast<std::uint64_t>(hasher(key)), cuckoo::DEFAULT_SEED);
+    }
+}
+
+/* findSlot()
+*
+*  compares the fingerprint against every tag of the bucket in one step, and reads the key bytes
+*  from the arena only for occupied slots whose tag matched. Returns the slot holding key, or -1.
+*/
+template <typename Value, typename Hasher, std::size_t SlotsPerBucket>
+int ArenaCuckooHash<Value, Hasher, SlotsPerBucket>::findSlot(const Bucket &bucket, std::string_view key, std::uint8_t tag) const
+{
+    for (std::uint32_t hits = cuckoo::matchTags<SlotsPerBucket>(bucket.tags, tag) & bucket.occupied; hits != 0; hits &= hits - 1)
+    {
+        int slot = cuckoo::lowestSlot(hits);
+        if (bucket.keys[slot].length == key.size() && keyOf(bucket.keys[slot]) == key)
+        {
+            return slot;
+        }
+    }
+
+    return -1;
+}
+
+/* freeSlot()
+*
+*  returns the first slot of the bucket without a record, or -1 when the bucket is full
+*/
+template <typename Value, typename Hasher, std::size_t SlotsPerBucket>
+int ArenaCuckooHash<Value, Hasher, SlotsPerBucket>::freeSlot(const Bucket &bucket)
+{
+    std::uint32_t empty = ~bucket.occupied & (SlotsPerBucket == 32 ? ~std::uint32_t(0) : (std::uint32_t(1) << SlotsPerBucket) - 1);
+
+    return empty == 0 ? -1 : cuckoo::lowestSlot(empty);
+}
+
+/* position()
+*
+*  returns the bucket of the key's record (and its table and slot), or -1 when the key is absent
+*/
+template <typename Value, typename Hasher, std::size_t SlotsPerBucket>
+std::int64_t ArenaCuckooHash<Value, Hasher, SlotsPerBucket>::position(std::string_view key, std::uint64_t hashCode, int &whichTable, int &slot) const
+{
+    std::uint8_t tag = static_cast<std::uint8_t>(hashCode);
+    std::size_t homePosition = cuckoo::hash1(hashCode, tableSize);
+
+    slot = findSlot(table1[homePosition], key, tag);
+    if (slot != -1)
+    {
+        whichTable = 1;
+        return static_cast<std::int64_t>(homePosition);
+    }
+
+    std::size_t evictionPosition = cuckoo::hash2(hashCode, tableSize);
+
+    slot = findSlot(table2[evictionPosition], key, tag);
+    if (slot != -1)
+    {
+        whichTable = 2;
+        return static_cast<std::int64_t>(evictionPosition);
+    }
+
+    return -1;
+}
+
+/* rehash()
+*
+*  moves every record into new tables of newTableSize buckets, or GROWTH_FACTOR times larger again while
+*  some record finds no path. Records keep their KeyRef, so the arena is not touched. Until every record
+*  is placed, only values leave the old tables (each record's KeyRef, tag and slot stay), so a failed
+*  attempt moves the values back and loses nothing. Returns 1, with every record where it was, when the
+*  tables cannot grow past MAX_TABLE_SIZE, and 0 otherwise.
+*/
+template <typename Value, typename Hasher, std::size_t SlotsPerBucket>
+bool ArenaCuckooHash<Value, Hasher, SlotsPerBucket>::rehash(std::size_t newTableSize)
+{
+    Bucket *previousTable1 = table1;
+    Bucket *previousTable2 = table2;
+    std::size_t previousTableSize = tableSize;
+    std::size_t previousCount = nodeCount;
+
+    for (; newTableSize <= cuckoo::MAX_TABLE_SIZE; newTableSize *= cuckoo::GROWTH_FACTOR)
+    {
+        Bucket *newTable1 = allocateTable(newTableSize);
+        Bucket *newTable2 = nullptr;
+        try
+        {
+            newTable2 = allocateTable(newTableSize);
+        }
+        catch (...)
+        {
+            cuckoo::freeZeroed(newTable1);
+            throw;
+        }
+
+        table1 = newTable1;
+        table2 = newTable2;
+        tableSize = newTableSize;
+        nodeCount = 0;
+
+        if (moveValues(previousTable1, previousTableSize) && moveValues(previousTable2, previousTableSize))
+        {
+            freeTable(previousTable1, previousTableSize);
+            freeTable(previousTable2, previousTableSize);
+
+            return 0;
+        }
+
+        // a record found no path: put the old tables back together and try larger ones
+        table1 = previousTable1;
+        table2 = previousTable2;
+        tableSize = previousTableSize;
+        nodeCount = previousCount;
+        returnValues(newTable1, newTableSize);
+        returnValues(newTable2, newTableSize);
+        freeTable(newTable1, newTableSize);
+        freeTable(newTable2, newTableSize);
+    }
+
+    std::cerr << "The hash table cannot grow past " << cuckoo::MAX_TABLE_SIZE << " buckets per table.\n";
+
+    return 1;
+}
+
+/* moveValues()
+*
+*  places every record of a replaced table in the current tables. Only the value moves; the replaced
+*  table keeps the record's KeyRef, tag and slot (with a moved-from value) for returnValues(). Returns
+*  false at the first record without a path.
+*/
+template <typename Value, typename Hasher, std::size_t SlotsPerBucket>
+bool ArenaCuckooHash<Value, Hasher, SlotsPerBucket>::moveValues(Bucket *table, std::size_t size)
+{
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        for (std::uint32_t used = table[i].occupied; used != 0; used &= used - 1)
+        {
+            int s = cuckoo::lowestSlot(used);
+            KeyRef ref = table[i].keys[s];
+            std::uint64_t hashCode = hashOf(keyOf(ref));
+
+            if (!placeInTables(ref, table[i].value(s), static_cast<std::uint8_t>(hashCode), hashCode))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/* returnValues()
+*
+*  with the replaced tables current again, moves the value of every record of an abandoned attempt back
+*  into its record's slot, which still holds the key
+*/
+template <typename Value, typename Hasher, std::size_t SlotsPerBucket>
+void ArenaCuckooHash<Value, Hasher, SlotsPerBucket>::returnValues(Bucket *table, std::size_t size)
+{
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        for (std::uint32_t used = table[i].occupied; used != 0; used &= used - 1)
+        {
+            int s = cuckoo::lowestSlot(used);
+            std::string_view key = keyOf(table[i].keys[s]);
+
+            int whichTable = -1;
+            int slot = -1;
+            std::int64_t bucket = position(key, hashOf(key), whichTable, slot);
+            Bucket &home = tableOf(whichTable)[bucket];
+            home.value(slot).~Value();
+            new (home.values[slot]) Value(std::move(table[i].value(s)));
+        }
+    }
+}
+
+/* compact()
+*
+*  copies the bytes of every stored key into a fresh arena and points the KeyRefs at the copies.
+*  Hash codes depend only on the bytes, so no record changes position.
+*/
+template <typename Value, typename Hasher, std::size_t SlotsPerBucket>
+void ArenaCuckooHash<Value, Hasher, SlotsPerBucket>::compact()
+{
+    std::vector<char> liveKeys;
+    liveKeys.reserve(arena.size() - deadBytes);
+
+    for (Bucket *table : { table1, table2 })
+    {
+        for (std::size_t i = 0; i < tableSize; ++i)
+        {
+            for (std::uint32_t used = table[i].occupied; used != 0; used &= used - 1)
+            {
+                KeyRef &ref = table[i].keys[cuckoo::lowestSlot(used)];
+                std::string_view key = keyOf(ref);
+
+                ref.offset = liveKeys.size();
+                liveKeys.insert(liveKeys.end(), key.begin(), key.end());
+            }
+        }
+    }
+
+    arena.swap(liveKeys);
+    keyData = arena.data();
+    deadBytes = 0;
+}
+
+/* arena_bytes()
+*
+*  the length of the arena, owned or mapped, including the bytes of removed keys
+*/
+template <typename Value, typename Hasher, std::size_t SlotsPerBucket>
+std::size_t ArenaCuckooHash<Value, Hasher, SlotsPerBucket>::arena_bytes() const
+{
+    if (mapping != nullptr)
+    {
+        return mappingBytes - sizeof(SnapshotHeader) - 2 * tableSize * sizeof(Bucket);
+    }
+
+    return arena.size();
+}
+
+/* save()
+*
+*  writes the SnapshotHeader, both tables as they are in memory and the arena to path. Returns false
+*  (and prints why) when the file cannot be written.
+*/
+template <typename Value, typename Hasher, std::size_t SlotsPerBucket>
+bool ArenaCuckooHash<Value, Hasher, SlotsPerBucket>::save(const std::string &path) const
+{
+    static_assert(std::is_trivially_copyable<Value>::value, "a snapshot stores values as raw bytes, so Value must be trivially copyable");
+
+    SnapshotHeader header = SnapshotHeader();
+    std::memcpy(header.magic, cuckoo::SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = cuckoo::SNAPSHOT_VERSION;
+    header.byteOrder = 0x01020304;
+    header.slots = SlotsPerBucket;
+    header.bucketBytes = sizeof(Bucket);
+    header.valueBytes = sizeof(Value);
+    header.tableSize = tableSize;
+    header.records = nodeCount;
+    header.arenaBytes = arena_bytes();
+    header.deadBytes = deadBytes;
+    if constexpr (cuckoo::has_seed<Hasher>::value)
+    {
+        header.seed = hasher.seed;
+    }
+    header.hashCheck = hashOf(SNAPSHOT_CHECK_KEY);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(table1), static_cast<std::streamsize>(tableSize * sizeof(Bucket)));
+    file.write(reinterpret_cast<const char *>(table2), static_cast<std::streamsize>(tableSize * sizeof(Bucket)));
+    file.write(keyData, static_cast<std::streamsize>(header.arenaBytes));
+    file.close();
+
+    if (!file)
+    {
+        std::cerr << "could not write the snapshot " << path << "\n";
+
+        return false;
+    }
+
+    return true;
+}
+
+/* open_mmap()
+*
+*  maps the snapshot at path and, once its header matches this table type, makes its tables and arena
+*  the table's own, in place of the current records. Nothing is copied: lookups read the mapped pages
+*  and the OS pages them in on first touch. Returns false (and prints why), keeping the current
+*  records, when the file cannot be mapped, is not a snapshot of this table type, or fails validTables().
+*/
+template <typename Value, typename Hasher, std::size_t SlotsPerBucket>
+bool ArenaCuckooHash<Value, Hasher, SlotsPerBucket>::open_mmap(const std::string &path)
+{
+    static_assert(std::is_trivially_copyable<Value>::value, "a snapshot stores values as raw bytes, so Value must be trivially copyable");
+
+    std::size_t bytes = 0;
+    const unsigned char *address = cuckoo::mapFile(path, bytes);
+    if (address == nullptr)
+    {
+        std::cerr << "could not map the snapshot " << path << "\n";
+
+        return false;
+    }
+
+    SnapshotHeader header;
+    bool valid = bytes >= sizeof(header);
+    if (valid)
+    {
+        std::memcpy(&header, address, sizeof(header));
+        valid = std::memcmp(header.magic, cuckoo::SNAPSHOT_MAGIC, sizeof(header.magic)) == 0
+            && header.version == cuckoo::SNAPSHOT_VERSION && header.byteOrder == 0x01020304
+            && header.slots == SlotsPerBucket && header.bucketBytes == sizeof(Bucket) && header.valueBytes == sizeof(Value)
+            && header.tableSize > 0 && header.tableSize <= cuckoo::MAX_TABLE_SIZE
+            && header.arenaBytes <= bytes && header.deadBytes <= header.arenaBytes
+            && bytes == sizeof(header) + 2 * header.tableSize * sizeof(Bucket) + header.arenaBytes;
+    }
+
+    // the seed comes from the snapshot, and the hash check confirms the rest of the Hasher agrees
+    Hasher snapshotHasher = hasher;
+    if constexpr (cuckoo::has_seed<Hasher>::value)
+    {
+        if (valid)
+        {
+            snapshotHasher = Hasher(header.seed);
+        }
+    }
+    std::swap(hasher, snapshotHasher);
+    if (valid && hashOf(SNAPSHOT_CHECK_KEY) != header.hashCheck)
+    {
+        valid = false;
+    }
+    if (valid && !validTables(header, reinterpret_cast<const Bucket *>(address + sizeof(header))))
+    {
+        valid = false;
+    }
+    if (!valid)
+    {
+        std::swap(hasher, snapshotHasher);
+        cuckoo::unmapFile(address, bytes);
+        std::cerr << "the file " << path << " is not a snapshot of this table type, or is corrupt\n";
+
+        return false;
+    }
+
+    release();
+
+    mapping = address;
+    mappingBytes = bytes;
+    tableSize = header.tableSize;
+    nodeCount = header.records;
+    deadBytes = header.deadBytes;
+    table1 = reinterpret_cast<Bucket *>(const_cast<unsigned char *>(address + sizeof(header)));
+    table2 = table1 + tableSize;
+    std::vector<char>().swap(arena);
+    keyData = reinterpret_cast<const char *>(table2 + tableSize);
+
+    return true;
+}
+
+/* validTables()
+*
+*  checks the 2 * header.tableSize buckets of a mapped snapshot: no bucket marks a slot beyond
+*  SlotsPerBucket as occupied, every occupied slot's KeyRef lies within the arena, and the occupied
+*  slots add up to header.records. Every later read of a key is then within the mapping.
+*/
+template <typename Value, typename Hasher, std::size_t SlotsPerBucket>
+bool ArenaCuckooHash<Value, Hasher, SlotsPerBucket>::validTables(const SnapshotHeader &header, const Bucket *tables)
+{
+    const std::uint32_t SLOT_MASK = SlotsPerBucket == 32 ? ~std::uint32_t(0) : (std::uint32_t(1) << SlotsPerBucket) - 1;
+
+    std::uint64_t records = 0;
+    for (std::size_t i = 0; i < 2 * header.tableSize; ++i)
+    {
+        if ((tables[i].occupied & ~SLOT_MASK) != 0)
+        {
+            return false;
+        }
+
+        for (std::uint32_t used = tables[i].occupied; used != 0; used &= used - 1)
+        {
+            KeyRef ref = tables[i].keys[cuckoo::lowestSlot(used)];
+            if (ref.offset > header.arenaBytes || ref.length > header.arenaBytes - ref.offset)
+            {
+                return false;
+            }
+            ++records;
+        }
+    }
+
+    return records == header.records;
+}
+
+/* detach()
+*
+*  turns a mapped snapshot into tables and an arena the table owns, so that they can change. Does
+*  nothing for a table that owns its memory already.
+*/
+template <typename Value, typename Hasher, std::size_t SlotsPerBucket>
+void ArenaCuckooHash<Value, Hasher, SlotsPerBucket>::detach()
+{
+    if (mapping == nullptr)
+    {
+        return;
+    }
+
+    Bucket *ownTable1 = allocateTable(tableSize);
+    Bucket *ownTable2 = allocateTable(tableSize);
+    std::memcpy(static_cast<void *>(ownTable1), table1, tableSize * sizeof(Bucket));
+    std::memcpy(static_cast<void *>(ownTable2), table2, tableSize * sizeof(Bucket));
+    arena.assign(keyData, keyData + arena_bytes());
+
+    cuckoo::unmapFile(mapping, mappingBytes);
+    mapping = nullptr;
+    mappingBytes = 0;
+    table1 = ownTable1;
+    table2 = ownTable2;
+    keyData = arena.data();
+}
+
+/* release()
+*
+*  frees the tables, or unmaps them when they belong to a snapshot
+*/
+template <typename Value, typename Hasher, std::size_t SlotsPerBucket>
+void ArenaCuckooHash<Value, Hasher, SlotsPerBucket>::release()
+{
+    if (mapping != nullptr)
+    {
+        cuckoo::unmapFile(mapping, mappingBytes);
+        mapping = nullptr;
+        mappingBytes = 0;
+    }
+    else
+    {
+        freeTable(table1, tableSize);
+        freeTable(table2, tableSize);
+    }
+
+    table1 = nullptr;
+    table2 = nullptr;
+}
+
+/* allocateTable()
+*
+*  allocates size buckets of zeroed memory. A zeroed bucket has no occupied slot.
+*/
+template <typename Value, typename Hasher, std::size_t SlotsPerBucket>
+typename ArenaCuckooHash<Value, Hasher, SlotsPerBucket>::Bucket *ArenaCuckooHash<Value, Hasher, SlotsPerBucket>::allocateTable(std::size_t size)
+{
+    static_assert(std::is_trivially_default_constructible<Bucket>::value, "an all-zero Bucket must be an empty Bucket");
+
+    return static_cast<Bucket *>(cuckoo::allocateZeroed(size * sizeof(Bucket), alignof(Bucket)));
+}
+
+/* freeTable()
+*
+*  destroys every value still stored in the table and frees the table's memory
+*/
+template <typename Value, typename Hasher, std::size_t SlotsPerBucket>
+void ArenaCuckooHash<Value, Hasher, SlotsPerBucket>::freeTable(Bucket *table, std::size_t size)
+{
+    if (!std::is_trivially_destructible<Value>::value)
+    {
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            for (std::uint32_t used = table[i].occupied; used != 0; used &= used - 1)
+            {
+                table[i].value(cuckoo::lowestSlot(used)).~Value();
+            }
+        }
+    }
+
+    cuckoo::freeZeroed(table);
+}
+
+/* display()
+*
+*  prints every record of both tables as "key : value"
+*/
+template <typename Value, typename Hasher, std::size_t SlotsPerBucket>
+void ArenaCuckooHash<Value, Hasher, SlotsPerBucket>::display() const
+{
+    for (Bucket *table : { table1, table2 })
+    {
+        for (std::size_t i = 0; i < tableSize; ++i)
+        {
+            for (std::uint32_t used = table[i].occupied; used != 0; used &= used - 1)
+            {
+                int s = cuckoo::lowestSlot(used);
+                std::cout << keyOf(table[i].keys[s]) << " : " << table[i].value(s) << "\n";
+            }
+        }
+    }
+}
+
+#endif // ARENACUCKOOHASH_HPP_INCLUDED
@@ -0,0 +1,1044 @@
+/*
+    Data Structures
+    Project Hash: Cuckoo Hashing
+    Author: Anthony Lupica <arl127@uakron.edu> 2022
+
+    Header file for ConcurrentCuckooHash, a thread-safe variant of the CuckooHash class template.
+
+    Any number of threads may call insert(), search(), contains() and remove() on one table.
+    The table layout is that of CuckooHash (two tables of tagged, cache-line sized buckets,
+    positions derived from one 64-bit hash code), and the buckets are guarded by LOCK_STRIPES
+    striped spinlocks, each a version counter that is odd while a writer holds it.
+
+    Ex.] Shared Birth Years
+    ConcurrentCuckooHash<std::uint64_t, int> birthYears;
+    birthYears.insert(42, 1963);            // from any thread
+    int year = 0;
+    if (birthYears.search(42, year)) ...    // from any other thread
+
+    Writers lock the stripes of every bucket they touch, always in ascending stripe order, so two
+    writers can never wait on each other in a cycle. An insert that needs displacements searches for
+    the path breadth-first without holding a lock, then locks every bucket on it (and the key's own
+    buckets) at once, checks that the path is unchanged and only then moves the records.
+
+    When Key and Value are trivially copyable, search() and contains() take no lock at all: they read
+    the stripe versions, copy the candidate records, and retry if a version changed in between
+    (a seqlock). Such records are kept as words of relaxed atomics, as are every bucket's tags and
+    hash codes, so that these racing reads (and those of the unlocked path search) are defined.
+    Other key and value types are read under the stripe locks instead, as copying them while a
+    writer moves them is not safe.
+
+    Growth locks every stripe and copies the records into tables of GROWTH_FACTOR times the size
+    (or larger, should a record find no place), destroying the old records only once every copy is
+    placed, so that a std::bad_alloc during growth loses nothing. The replaced tables are kept (without their records) until the table is destroyed, so an
+    optimistic reader still holding the previous tables never touches freed memory. Together the
+    retired tables are never larger than the current ones.
+
+    Results are returned rather than printed: insert() returns a cuckoo::Status (Inserted, Exists for
+    a duplicate key, or Failed when the tables cannot grow past MAX_TABLE_SIZE), remove() returns false
+    for a missing key, and search() copies the value out.
+*/
+
+#ifndef CONCURRENTCUCKOOHASH_HPP_INCLUDED
+#define CONCURRENTCUCKOOHASH_HPP_INCLUDED
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "CuckooHash.hpp"
+
+namespace cuckoo
+{
+    // number of spinlock stripes of a ConcurrentCuckooHash (a power of two). Bucket i of table 1 and 2
+    // maps to stripes 2i and 2i + 1, modulo the stripe count
+    const std::size_t LOCK_STRIPES = 4096;
+
+    /* cpuRelax()
+    *
+    *  backs off inside a spin loop
+    */
+    inline void cpuRelax()
+    {
+#if defined(__SSE2__) || defined(_M_X64)
+        _mm_pause();
+#else
+        std::this_thread::yield();
+#endif
+    }
+}
+
+template <typename Key, typename Value, typename Hasher = cuckoo::Hash<Key>, typename KeyEqual = cuckoo::Equal<Key>, std::size_t SlotsPerBucket = 4>
+class ConcurrentCuckooHash
+{
+    static_assert(SlotsPerBucket >= 1 && SlotsPerBucket <= 32, "SlotsPerBucket must be between 1 and 32");
+
+    private:
+
+        struct HashNode
+        {
+            Key key;     // key
+            Value value; // value
+        };
+
+        // lookups copy records without a lock only when a torn copy is harmless (it is discarded after the version check)
+        static constexpr bool OPTIMISTIC_READS = std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<Value>::value;
+
+        // 64-bit words of a record kept for optimistic reads
+        static constexpr std::size_t RECORD_WORDS = (sizeof(HashNode) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+
+        // the records of a bucket as objects, read and written under the stripe locks only
+        struct LockedRecords
+        {
+            alignas(HashNode) unsigned char storage[SlotsPerBucket][sizeof(HashNode)];
+        };
+
+        // the records of a bucket as the words of their bytes, each an atomic, so that an optimistic lookup
+        // racing a writer reads a torn copy (which it discards) rather than racing on plain memory
+        struct WordRecords
+        {
+            std::atomic<std::uint64_t> words[SlotsPerBucket][RECORD_WORDS];
+        };
+
+        // one hash position. Next to each tag the full hash code of the record is kept, so that a
+        // displacement path search running without locks never has to read (and hash) a key. Tags and hash
+        // codes are atomics, which that search (and optimistic lookups) load relaxed while writers change them
+        struct alignas(cuckoo::CACHE_LINE) Bucket
+        {
+            std::atomic<std::uint8_t> tags[SlotsPerBucket];                       // fingerprint of each slot (EMPTY_TAG marks a free slot)
+            std::atomic<std::uint64_t> hashCodes[SlotsPerBucket];                 // hash code of each slot's record
+            std::conditional_t<OPTIMISTIC_READS, WordRecords, LockedRecords> records; // the records
+
+            HashNode &node(std::size_t slot)             // the record of a slot (without OPTIMISTIC_READS)
+            { return *std::launder(reinterpret_cast<HashNode *>(records.storage[slot])); }
+            const HashNode &node(std::size_t slot) const
+            { return *std::launder(reinterpret_cast<const HashNode *>(records.storage[slot])); }
+        };
+
+        // both tables of one size. Readers and writers find them through "current"
+        struct Generation
+        {
+            std::size_t tableSize; // number of buckets per table
+            Bucket *table1;        // the primary hash table
+            Bucket *table2;        // the secondary "eviction" table
+        };
+
+        // a spinlock that doubles as the version counter of the buckets it guards
+        struct alignas(cuckoo::CACHE_LINE) LockStripe
+        {
+            std::atomic<std::uint64_t> version; // odd while a writer holds the stripe
+        };
+
+        // one bucket visited by the displacement path search (see CuckooHash::PathNode)
+        struct PathNode
+        {
+            std::size_t bucket; // bucket index within its table
+            std::size_t parent; // node whose record moves into this bucket (NO_PARENT for the key's own buckets)
+            std::size_t depth;  // number of moves from the key's own bucket to this one
+            int table;          // 1 or 2
+            int slot;           // slot of the parent bucket holding the record that moves here
+        };
+
+        static constexpr std::size_t NO_PARENT = static_cast<std::size_t>(-1);
+
+        // same bounds as a CuckooHash of two tables
+        static constexpr std::size_t MAX_PATH_LENGTH = cuckoo::maxPathLength(SlotsPerBucket, 2);
+        static constexpr double MAX_LOAD_FACTOR = cuckoo::maxLoadFactor(SlotsPerBucket, 2);
+
+        // private data members
+        std::atomic<Generation *> current;       // the tables in use
+        std::vector<Generation *> retired;       // replaced tables, freed by the destructor (only touched with every stripe held)
+        std::unique_ptr<LockStripe[]> stripes;   // LOCK_STRIPES spinlocks / version counters
+        std::atomic<std::size_t> count;          // number of records
+        Hasher hasher;                           // hash function object, evaluated once per operation by hashOf()
+        KeyEqual keyEqual;                       // key equality predicate
+
+        // private methods
+        std::uint64_t hashOf(const Key &key) const;                              // the 64-bit hash code all positions derive from (see CuckooHash::hashOf())
+        static std::size_t stripeOf(int whichTable, std::size_t bucket);         // the stripe guarding a bucket
+        void lockStripes(std::vector<std::size_t> &stripeList) const;            // sorts, deduplicates and locks the stripes in ascending order
+        void unlockStripes(const std::vector<std::size_t> &stripeList) const;    // releases stripes taken by lockStripes()
+        void lockStripe(std::size_t stripe) const;                               // spins until the stripe is held
+        void unlockStripe(std::size_t stripe) const;                             // releases a held stripe, publishing its buckets' writes
+        bool lookup(const Key &key, Value *value) const;                         // shared body of search() and contains()
+        bool readLocked(const Generation &gen, const Key &key, std::uint64_t hashCode, Value *value) const; // lookup with the key's stripes held
+        bool readOptimistic(const Bucket &bucket, const Key &key, std::uint8_t tag, Value *value) const;    // racy copy of a matching record
+        int findSlot(const Bucket &bucket, const Key &key, std::uint8_t tag) const; // slot holding key within bucket, or -1
+        static std::uint32_t loadTags(const Bucket &bucket, std::uint8_t tag);   // bit mask of the slots whose tag is tag, from a relaxed load of each
+        static HashNode loadRecord(const Bucket &bucket, int slot);              // a copy of a slot's record (with OPTIMISTIC_READS), torn if a writer is moving it
+        static void putRecord(Bucket &bucket, int slot, HashNode &&record, std::uint64_t hashCode); // seats a record in a free slot
+        static HashNode takeRecord(Bucket &bucket, int slot);                    // moves a slot's record out and frees the slot
+        static void eraseSlot(Bucket &bucket, int slot);                         // destroys a slot's record and frees the slot
+        std::size_t findPath(const Generation &gen, std::uint64_t hashCode, std::vector<PathNode> &path, int &slot) const; // breadth-first search for a free slot
+        bool pathHolds(const Generation &gen, const std::vector<PathNode> &path, std::size_t node, int slot) const; // re-checks a path with its stripes held
+        void movePath(Generation &gen, const std::vector<PathNode> &path, std::size_t node, int slot, HashNode &&record, std::uint64_t hashCode); // shifts the path and seats the record
+        bool placeUnlocked(Generation &gen, HashNode &record, std::uint64_t hashCode, std::vector<PathNode> &path); // seats a record while no other thread can run, false (keeping it) without a path
+        bool grow(Generation *seen);                                             // replaces the tables seen by a writer with larger ones
+        Generation *rebuild(Generation &from);                                   // copies every record of from into larger tables, nullptr past MAX_TABLE_SIZE
+        bool copyRecords(const Generation &from, Generation &to, std::vector<PathNode> &path); // places a copy of every record of from, false if one has no path
+        static Generation *newGeneration(std::size_t tableSize);                 // empty tables of tableSize buckets each
+        static void freeGeneration(Generation *gen);                             // destroys a generation's records and frees its tables
+        static Bucket *tableOf(const Generation &gen, int whichTable);           // table 1 or 2 of a generation
+        static void freeRecords(Generation &gen);                                // destroys every record of a generation
+
+    public:
+
+        // ctors and dtor
+        ConcurrentCuckooHash();                                                  // default constructor
+        ConcurrentCuckooHash(const ConcurrentCuckooHash &) = delete;             // tables are owned, copying is not supported
+        ConcurrentCuckooHash &operator=(const ConcurrentCuckooHash &) = delete;
+        ~ConcurrentCuckooHash();                                                 // destructor (no other thread may use the table any more)
+
+        // public methods
+        cuckoo::Status insert(const Key &key, const Value &value); // insert into the hash table: Inserted, Exists, or Failed if it cannot grow
+        bool search(const Key &key, Value &value) const;   // copy a record's value into value, false if absent
+        bool contains(const Key &key) const;               // find if the hash table contains a record
+        bool remove(const Key &key);                       // remove a record from the hash table, false if absent
+        std::size_t size() const                           // getter for the number of total records
+        { return count.load(std::memory_order_relaxed); }
+        std::size_t capacity() const                       // getter for the number of buckets per table
+        { return current.load(std::memory_order_acquire)->tableSize; }
+        double load_factor() const                         // fraction of all slots (both tables) holding a record
+        { return static_cast<double>(size()) / (2.0 * capacity() * SlotsPerBucket); }
+};
+
+/* Default Constructor
+*
+*  Initialize table size to INITIAL_TABLE_SIZE, with every stripe unlocked.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket>
+ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::ConcurrentCuckooHash()
+    : current(nullptr), stripes(new LockStripe[cuckoo::LOCK_STRIPES]()), count(0)
+{
+    static_assert(std::is_trivially_default_constructible<Bucket>::value, "an all-zero Bucket must be an empty Bucket");
+
+    current.store(newGeneration(cuckoo::INITIAL_TABLE_SIZE), std::memory_order_release);
+}
+
+/* ~Destructor()
+*
+*  destroys the records and frees the current and every retired generation of tables
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket>
+ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::~ConcurrentCuckooHash()
+{
+    freeGeneration(current.load(std::memory_order_acquire));
+
+    for (Generation *old : retired)
+    {
+        freeGeneration(old);
+    }
+}
+
+/* insert()
+*
+*  stores the record if the key is unique. A free slot in one of the key's own buckets is taken with
+*  just those two buckets locked. Otherwise a displacement path is searched for without locks, and
+*  every bucket on it is locked and re-checked before any record moves; a path another writer changed
+*  in the meantime is simply searched for again. No path, or a full table, grows the tables first.
+*  Returns cuckoo::Status::Inserted, Exists if the key already exists, or Failed if the tables would
+*  have to grow past MAX_TABLE_SIZE.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket>
+cuckoo::Status ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::insert(const Key &key, const Value &value)
+{
+    std::uint64_t hashCode = hashOf(key);
+    std::uint8_t tag = cuckoo::tagOf(hashCode);
+    std::vector<PathNode> path;
+    std::vector<std::size_t> held;
+    HashNode record{ key, value }; // copied before any stripe is held, so a throwing copy leaves none locked
+
+    for (;;)
+    {
+        Generation *gen = current.load(std::memory_order_acquire);
+        if (static_cast<double>(size() + 1) > MAX_LOAD_FACTOR * 2.0 * gen->tableSize * SlotsPerBucket)
+        {
+            if (!grow(gen))
+            {
+                return cuckoo::Status::Failed;
+            }
+            continue;
+        }
+
+        std::size_t home = cuckoo::hash1(hashCode, gen->tableSize);
+        std::size_t eviction = cuckoo::hash2(hashCode, gen->tableSize);
+
+        // search the displacement path (of length 0 when one of the key's own buckets has room) unlocked
+        int slot = -1;
+        std::size_t node = findPath(*gen, hashCode, path, slot);
+        if (node == NO_PARENT)
+        {
+            if (!grow(gen))
+            {
+                return cuckoo::Status::Failed;
+            }
+            continue;
+        }
+
+        // lock the key's own buckets, for the duplicate check, and every bucket on the path
+        held.clear();
+        held.push_back(stripeOf(1, home));
+        held.push_back(stripeOf(2, eviction));
+        for (std::size_t n = node; n != NO_PARENT; n = path[n].parent)
+        {
+            held.push_back(stripeOf(path[n].table, path[n].bucket));
+        }
+        lockStripes(held);
+
+        // the tables may have grown, and the path may have changed, before the locks were taken
+        if (current.load(std::memory_order_relaxed) != gen || !pathHolds(*gen, path, node, slot))
+        {
+            unlockStripes(held);
+            continue;
+        }
+
+        if (findSlot(gen->table1[home], key, tag) != -1 || findSlot(gen->table2[eviction], key, tag) != -1)
+        {
+            unlockStripes(held);
+
+            return cuckoo::Status::Exists;
+        }
+
+        movePath(*gen, path, node, slot, std::move(record), hashCode);
+        count.fetch_add(1, std::memory_order_relaxed);
+        unlockStripes(held);
+
+        return cuckoo::Status::Inserted;
+    }
+}
+
+/* search()
+*
+*  copies the value of the key's record into value and returns true, or returns false if absent
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket>
+bool ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::search(const Key &key, Value &value) const
+{
+    return lookup(key, &value);
+}
+
+/* contains()
+*
+*  returns true if the key is found in the table, and false otherwise
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket>
+bool ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::contains(const Key &key) const
+{
+    return lookup(key, nullptr);
+}
+
+/* remove()
+*
+*  deletes the record with both of the key's buckets locked. Returns false if there is no such record.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket>
+bool ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::remove(const Key &key)
+{
+    std::uint64_t hashCode = hashOf(key);
+    std::uint8_t tag = cuckoo::tagOf(hashCode);
+    std::vector<std::size_t> held;
+
+    for (;;)
+    {
+        Generation *gen = current.load(std::memory_order_acquire);
+        std::size_t positions[2] = { cuckoo::hash1(hashCode, gen->tableSize), cuckoo::hash2(hashCode, gen->tableSize) };
+
+        held.assign({ stripeOf(1, positions[0]), stripeOf(2, positions[1]) });
+        lockStripes(held);
+
+        if (current.load(std::memory_order_relaxed) != gen)
+        {
+            unlockStripes(held);
+            continue;
+        }
+
+        for (int t = 1; t <= 2; ++t)
+        {
+            Bucket &bucket = tableOf(*gen, t)[positions[t - 1]];
+            int slot = findSlot(bucket, key, tag);
+            if (slot != -1)
+            {
+                eraseSlot(bucket, slot);
+                count.fetch_sub(1, std::memory_order_relaxed);
+                unlockStripes(held);
+
+                return true;
+            }
+        }
+
+        unlockStripes(held);
+
+        return false;
+    }
+}
+
+/* lookup()
+*
+*  finds the key's record and copies its value into *value (unless value is nullptr). With OPTIMISTIC_READS
+*  no lock is taken: the stripe versions are read before and after copying, and the lookup is repeated
+*  if either was odd (a writer held it) or changed. The current tables are re-read after the versions,
+*  so a lookup that saw the versions of a finished growth also sees the tables it installed.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket>
+bool ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::lookup(const Key &key, Value *value) const
+{
+    std::uint64_t hashCode = hashOf(key);
+
+    if constexpr (OPTIMISTIC_READS)
+    {
+        std::uint8_t tag = cuckoo::tagOf(hashCode);
+
+        for (;;)
+        {
+            Generation *gen = current.load(std::memory_order_acquire);
+            std::size_t home = cuckoo::hash1(hashCode, gen->tableSize);
+            std::size_t eviction = cuckoo::hash2(hashCode, gen->tableSize);
+            const std::atomic<std::uint64_t> &version1 = stripes[stripeOf(1, home)].version;
+            const std::atomic<std::uint64_t> &version2 = stripes[stripeOf(2, eviction)].version;
+
+            std::uint64_t before1 = version1.load(std::memory_order_acquire);
+            std::uint64_t before2 = version2.load(std::memory_order_acquire);
+            if (((before1 | before2) & 1) != 0 || current.load(std::memory_order_acquire) != gen)
+            {
+                cuckoo::cpuRelax();
+                continue;
+            }
+
+            bool found = readOptimistic(gen->table1[home], key, tag, value) || readOptimistic(gen->table2[eviction], key, tag, value);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (version1.load(std::memory_order_relaxed) == before1 && version2.load(std::memory_order_relaxed) == before2)
+            {
+                return found;
+            }
+        }
+    }
+    else
+    {
+        std::vector<std::size_t> held;
+
+        for (;;)
+        {
+            Generation *gen = current.load(std::memory_order_acquire);
+            held.assign({ stripeOf(1, cuckoo::hash1(hashCode, gen->tableSize)), stripeOf(2, cuckoo::hash2(hashCode, gen->tableSize)) });
+            lockStripes(held);
+
+            if (current.load(std::memory_order_relaxed) != gen)
+            {
+                unlockStripes(held);
+                continue;
+            }
+
+            bool found = readLocked(*gen, key, hashCode, value);
+            unlockStripes(held);
+
+            return found;
+        }
+    }
+}
+
+/* readLocked()
+*
+*  looks the key up in both of its buckets and copies out the value, with the buckets' stripes held
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket>
+bool ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::readLocked(const Generation &gen, const Key &key, std::uint64_t hashCode, Value *value) const
+{
+    std::uint8_t tag = cuckoo::tagOf(hashCode);
+    const Bucket *buckets[2] = { &gen.table1[cuckoo::hash1(hashCode, gen.tableSize)], &gen.table2[cuckoo::hash2(hashCode, gen.tableSize)] };
+
+    for (const Bucket *bucket : buckets)
+    {
+        int slot = findSlot(*bucket, key, tag);
+        if (slot != -1)
+        {
+            if (value != nullptr)
+            {
+                if constexpr (OPTIMISTIC_READS)
+                {
+                    *value = loadRecord(*bucket, slot).value;
+                }
+                else
+                {
+                    *value = bucket->node(slot).value;
+                }
+            }
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* readOptimistic()
+*
+*  copies the bucket's tags, and each record whose tag matches, to the stack before looking at them,
+*  so that a writer changing the bucket meanwhile can only produce a wrong answer (which lookup()
+*  discards), never a crash. Every load is an atomic one, so the race is a defined one.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket>
+bool ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::readOptimistic(const Bucket &bucket, const Key &key, std::uint8_t tag, Value *value) const
+{
+    for (std::uint32_t hits = loadTags(bucket, tag); hits != 0; hits &= hits - 1)
+    {
+        HashNode record = loadRecord(bucket, cuckoo::lowestSlot(hits));
+        if (keyEqual(record.key, key))
+        {
+            if (value != nullptr)
+            {
+                *value = record.value;
+            }
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* findSlot()
+*
+*  returns the slot of the bucket holding key, or -1 (see CuckooHash::findSlot())
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket>
+int ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::findSlot(const Bucket &bucket, const Key &key, std::uint8_t tag) const
+{
+    for (std::uint32_t hits = loadTags(bucket, tag); hits != 0; hits &= hits - 1)
+    {
+        int slot = cuckoo::lowestSlot(hits);
+        if constexpr (OPTIMISTIC_READS)
+        {
+            if (keyEqual(loadRecord(bucket, slot).key, key))
+            {
+                return slot;
+            }
+        }
+        else if (keyEqual(bucket.node(slot).key, key))
+        {
+            return slot;
+        }
+    }
+
+    return -1;
+}
+
+/* loadTags()
+*
+*  loads the bucket's tags (relaxed, as a writer may be changing them) and matches them against tag
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket>
+std::uint32_t ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::loadTags(const Bucket &bucket, std::uint8_t tag)
+{
+    std::uint8_t tags[SlotsPerBucket];
+    for (std::size_t s = 0; s < SlotsPerBucket; ++s)
+    {
+        tags[s] = bucket.tags[s].load(std::memory_order_relaxed);
+    }
+
+    return cuckoo::matchTags<SlotsPerBucket>(tags, tag);
+}
+
+/* loadRecord()
+*
+*  copies a slot's record out of its words (relaxed loads). Only a lookup whose stripe versions stayed
+*  unchanged, or a thread holding the slot's stripe, may trust the copy.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket>
+typename ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::HashNode ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::loadRecord(const Bucket &bucket, int slot)
+{
+    std::uint64_t words[RECORD_WORDS];
+    for (std::size_t w = 0; w < RECORD_WORDS; ++w)
+    {
+        words[w] = bucket.records.words[slot][w].load(std::memory_order_relaxed);
+    }
+
+    alignas(HashNode) unsigned char copy[sizeof(HashNode)];
+    std::memcpy(copy, words, sizeof(HashNode));
+
+    return *std::launder(reinterpret_cast<const HashNode *>(copy));
+}
+
+/* putRecord()
+*
+*  seats a record in a free slot: its words (or the object itself, without OPTIMISTIC_READS), its hash
+*  code, and last its tag
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket>
+void ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::putRecord(Bucket &bucket, int slot, HashNode &&record, std::uint64_t hashCode)
+{
+    if constexpr (OPTIMISTIC_READS)
+    {
+        std::uint64_t words[RECORD_WORDS] = {};
+        std::memcpy(words, &record, sizeof(HashNode));
+        for (std::size_t w = 0; w < RECORD_WORDS; ++w)
+        {
+            bucket.records.words[slot][w].store(words[w], std::memory_order_relaxed);
+        }
+    }
+    else
+    {
+        new (bucket.records.storage[slot]) HashNode{ std::move(record.key), std::move(record.value) };
+    }
+    bucket.hashCodes[slot].store(hashCode, std::memory_order_relaxed);
+    bucket.tags[slot].store(cuckoo::tagOf(hashCode), std::memory_order_relaxed);
+}
+
+/* takeRecord()
+*
+*  moves a slot's record out and frees the slot
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket>
+typename ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::HashNode ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::takeRecord(Bucket &bucket, int slot)
+{
+    if constexpr (OPTIMISTIC_READS)
+    {
+        HashNode record = loadRecord(bucket, slot);
+        bucket.tags[slot].store(cuckoo::EMPTY_TAG, std::memory_order_relaxed);
+
+        return record;
+    }
+    else
+    {
+        HashNode record{ std::move(bucket.node(slot).key), std::move(bucket.node(slot).value) };
+        eraseSlot(bucket, slot);
+
+        return record;
+    }
+}
+
+/* eraseSlot()
+*
+*  destroys a slot's record (nothing to do for the trivially copyable records of OPTIMISTIC_READS) and frees the slot
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket>
+void ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::eraseSlot(Bucket &bucket, int slot)
+{
+    if constexpr (!OPTIMISTIC_READS)
+    {
+        bucket.node(slot).~HashNode();
+    }
+    bucket.tags[slot].store(cuckoo::EMPTY_TAG, std::memory_order_relaxed);
+}
+
+/* findPath()
+*
+*  breadth-first search from the key's two buckets for a bucket with a free slot (see CuckooHash::findPath()).
+*  Alternate buckets come from the stored hash codes, so the search reads no key and may run without locks;
+*  what it finds is only a candidate, which insert() re-checks with pathHolds().
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket>
+std::size_t ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::findPath(const Generation &gen, std::uint64_t hashCode, std::vector<PathNode> &path, int &slot) const
+{
+    path.clear();
+    path.push_back(PathNode{ cuckoo::hash1(hashCode, gen.tableSize), NO_PARENT, 0, 1, -1 });
+    path.push_back(PathNode{ cuckoo::hash2(hashCode, gen.tableSize), NO_PARENT, 0, 2, -1 });
+
+    for (std::size_t head = 0; head < path.size(); ++head)
+    {
+        PathNode at = path[head];
+        const Bucket &bucket = tableOf(gen, at.table)[at.bucket];
+
+        std::uint32_t empty = loadTags(bucket, cuckoo::EMPTY_TAG);
+        if (empty != 0)
+        {
+            slot = cuckoo::lowestSlot(empty);
+            return head;
+        }
+
+        if (at.depth >= MAX_PATH_LENGTH)
+        {
+            continue;
+        }
+
+        for (std::size_t s = 0; s < SlotsPerBucket && path.size() < cuckoo::MAX_SEARCH_BUCKETS; ++s)
+        {
+            int otherTable = at.table == 1 ? 2 : 1;
+            std::uint64_t occupantHash = bucket.hashCodes[s].load(std::memory_order_relaxed);
+            std::size_t otherBucket = otherTable == 1 ? cuckoo::hash1(occupantHash, gen.tableSize) : cuckoo::hash2(occupantHash, gen.tableSize);
+
+            bool onPath = false;
+            for (std::size_t n = head; n != NO_PARENT && !onPath; n = path[n].parent)
+            {
+                onPath = path[n].table == otherTable && path[n].bucket == otherBucket;
+            }
+
+            if (!onPath)
+            {
+                path.push_back(PathNode{ otherBucket, head, at.depth + 1, otherTable, static_cast<int>(s) });
+            }
+        }
+    }
+
+    return NO_PARENT;
+}
+
+/* pathHolds()
+*
+*  with every stripe on the path held: the last bucket's slot is still free, and every record on the path
+*  still sits where the search saw it, with a hash code that still leads to the next bucket
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket>
+bool ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::pathHolds(const Generation &gen, const std::vector<PathNode> &path, std::size_t node, int slot) const
+{
+    if (tableOf(gen, path[node].table)[path[node].bucket].tags[slot].load(std::memory_order_relaxed) != cuckoo::EMPTY_TAG)
+    {
+        return false;
+    }
+
+    for (; path[node].parent != NO_PARENT; node = path[node].parent)
+    {
+        const PathNode &to = path[node];
+        const Bucket &from = tableOf(gen, path[to.parent].table)[path[to.parent].bucket];
+        std::uint64_t occupantHash = from.hashCodes[to.slot].load(std::memory_order_relaxed);
+        std::size_t target = to.table == 1 ? cuckoo::hash1(occupantHash, gen.tableSize) : cuckoo::hash2(occupantHash, gen.tableSize);
+
+        if (from.tags[to.slot].load(std::memory_order_relaxed) == cuckoo::EMPTY_TAG || target != to.bucket)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* movePath()
+*
+*  shifts each record on the path one bucket forward, starting next to the free slot, and seats the
+*  new record in the slot freed at the path's start
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket>
+void ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::movePath(Generation &gen, const std::vector<PathNode> &path, std::size_t node, int slot, HashNode &&record, std::uint64_t hashCode)
+{
+    for (; path[node].parent != NO_PARENT; node = path[node].parent)
+    {
+        const PathNode &to = path[node];
+        Bucket &source = tableOf(gen, path[to.parent].table)[path[to.parent].bucket];
+        Bucket &target = tableOf(gen, to.table)[to.bucket];
+
+        std::uint64_t movedHash = source.hashCodes[to.slot].load(std::memory_order_relaxed);
+        putRecord(target, slot, takeRecord(source, to.slot), movedHash);
+
+        slot = to.slot;
+    }
+
+    putRecord(tableOf(gen, path[node].table)[path[node].bucket], slot, std::move(record), hashCode);
+}
+
+/* placeUnlocked()
+*
+*  seats a record in tables no other thread can reach (during growth). Returns false, leaving the record
+*  untouched, if no path was found.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket>
+bool ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::placeUnlocked(Generation &gen, HashNode &record, std::uint64_t hashCode, std::vector<PathNode> &path)
+{
+    int slot = -1;
+    std::size_t node = findPath(gen, hashCode, path, slot);
+    if (node == NO_PARENT)
+    {
+        return false;
+    }
+
+    movePath(gen, path, node, slot, std::move(record), hashCode);
+
+    return true;
+}
+
+/* grow()
+*
+*  locks every stripe (in ascending order, like any writer), and if the tables are still those the
+*  caller saw, rebuilds them larger. Waiting for every stripe means no writer and no locked reader is
+*  inside the tables while the records are copied. Returns false past MAX_TABLE_SIZE. The stripes are
+*  released however grow() ends, so a std::bad_alloc from rebuild() leaves the table usable (and unchanged).
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket>
+bool ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::grow(Generation *seen)
+{
+    struct AllStripes
+    {
+        const ConcurrentCuckooHash &table;
+
+        explicit AllStripes(const ConcurrentCuckooHash &owner) : table(owner)
+        {
+            for (std::size_t s = 0; s < cuckoo::LOCK_STRIPES; ++s)
+            {
+                table.lockStripe(s);
+            }
+        }
+        ~AllStripes()
+        {
+            for (std::size_t s = cuckoo::LOCK_STRIPES; s > 0; --s)
+            {
+                table.unlockStripe(s - 1);
+            }
+        }
+    } held(*this);
+
+    if (current.load(std::memory_order_relaxed) != seen)
+    {
+        return true;
+    }
+
+    Generation *next = rebuild(*seen);
+    if (next == nullptr)
+    {
+        return false;
+    }
+    current.store(next, std::memory_order_release);
+
+    return true;
+}
+
+/* rebuild()
+*
+*  places a copy of every record of from into new tables GROWTH_FACTOR times the size, trying larger
+*  sizes while some record finds no displacement path. Only once every record is placed are from's
+*  records destroyed and from retired (its memory is kept for optimistic readers); until then from is
+*  left untouched, so a std::bad_alloc, or running past MAX_TABLE_SIZE (which returns nullptr), loses nothing.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket>
+typename ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::Generation *ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::rebuild(Generation &from)
+{
+    std::vector<PathNode> path;
+    retired.reserve(retired.size() + 1);
+
+    for (std::size_t newTableSize = from.tableSize * cuckoo::GROWTH_FACTOR; newTableSize <= cuckoo::MAX_TABLE_SIZE; newTableSize *= cuckoo::GROWTH_FACTOR)
+    {
+        Generation *next = newGeneration(newTableSize);
+        bool placed = false;
+        try
+        {
+            placed = copyRecords(from, *next, path);
+        }
+        catch (...)
+        {
+            freeGeneration(next);
+            throw;
+        }
+
+        if (placed)
+        {
+            freeRecords(from);
+            retired.push_back(&from);
+
+            return next;
+        }
+        freeGeneration(next);
+    }
+
+    return nullptr;
+}
+
+/* copyRecords()
+*
+*  places a copy of every record of from into to (which no other thread can reach yet). Returns false
+*  at the first record without a displacement path.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket>
+bool ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::copyRecords(const Generation &from, Generation &to, std::vector<PathNode> &path)
+{
+    for (int t = 1; t <= 2; ++t)
+    {
+        const Bucket *table = tableOf(from, t);
+        for (std::size_t i = 0; i < from.tableSize; ++i)
+        {
+            for (std::size_t s = 0; s < SlotsPerBucket; ++s)
+            {
+                if (table[i].tags[s].load(std::memory_order_relaxed) == cuckoo::EMPTY_TAG)
+                {
+                    continue;
+                }
+
+                std::uint64_t hashCode = table[i].hashCodes[s].load(std::memory_order_relaxed);
+                HashNode record = [&]
+                {
+                    if constexpr (OPTIMISTIC_READS)
+                    {
+                        return loadRecord(table[i], static_cast<int>(s));
+                    }
+                    else
+                    {
+                        return table[i].node(s);
+                    }
+                }();
+                if (!placeUnlocked(to, record, hashCode, path))
+                {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+/* newGeneration()
+*
+*  allocates two empty tables of tableSize buckets. Throws std::bad_alloc, with nothing left allocated.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket>
+typename ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::Generation *ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::newGeneration(std::size_t tableSize)
+{
+    std::unique_ptr<Generation> gen(new Generation{ tableSize, nullptr, nullptr });
+    gen->table1 = static_cast<Bucket *>(cuckoo::allocateZeroed(tableSize * sizeof(Bucket), alignof(Bucket)));
+    try
+    {
+        gen->table2 = static_cast<Bucket *>(cuckoo::allocateZeroed(tableSize * sizeof(Bucket), alignof(Bucket)));
+    }
+    catch (...)
+    {
+        cuckoo::freeZeroed(gen->table1);
+        throw;
+    }
+
+    return gen.release();
+}
+
+/* freeGeneration()
+*
+*  destroys every record left in a generation and frees its tables
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket>
+void ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::freeGeneration(Generation *gen)
+{
+    freeRecords(*gen);
+    cuckoo::freeZeroed(gen->table1);
+    cuckoo::freeZeroed(gen->table2);
+    delete gen;
+}
+
+/* hashOf
+*
+*  the one hash computation of an operation (see CuckooHash::hashOf())
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket>
+std::uint64_t ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::hashOf(const Key &key) const
+{
+    if constexpr (cuckoo::is_avalanching<Hasher>::value)
+    {
+        return static_cast<std::uint64_t>(hasher(key));
+    }
+    else
+    {
+        return cuckoo::mixInt(static_cast<std::uint64_t>(hasher(key)), cuckoo::DEFAULT_SEED);
+    }
+}
+
+/* stripeOf()
+*
+*  maps a bucket of table 1 or 2 to the stripe guarding it
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket>
+std::size_t ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::stripeOf(int whichTable, std::size_t bucket)
+{
+    return (bucket * 2 + static_cast<std::size_t>(whichTable - 1)) & (cuckoo::LOCK_STRIPES - 1);
+}
+
+/* lockStripes()
+*
+*  locks a set of stripes in ascending order, the one order every writer uses, so no two writers
+*  can each hold a stripe the other waits for. Duplicates (buckets sharing a stripe) are locked once.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket>
+void ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::lockStripes(std::vector<std::size_t> &stripeList) const
+{
+    std::sort(stripeList.begin(), stripeList.end());
+    stripeList.erase(std::unique(stripeList.begin(), stripeList.end()), stripeList.end());
+
+    for (std::size_t stripe : stripeList)
+    {
+        lockStripe(stripe);
+    }
+}
+
+/* unlockStripes()
+*
+*  releases the stripes held by lockStripes()
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket>
+void ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::unlockStripes(const std::vector<std::size_t> &stripeList) const
+{
+    for (std::size_t stripe : stripeList)
+    {
+        unlockStripe(stripe);
+    }
+}
+
+/* lockStripe()
+*
+*  spins until the stripe's version is even and this thread made it odd. The release fence keeps the
+*  bucket writes that follow from becoming visible before the odd version does, which is what lets an
+*  optimistic reader trust an unchanged even version.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket>
+void ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::lockStripe(std::size_t stripe) const
+{
+    std::atomic<std::uint64_t> &version = stripes[stripe].version;
+
+    for (;;)
+    {
+        std::uint64_t seen = version.load(std::memory_order_relaxed);
+        if ((seen & 1) == 0 && version.compare_exchange_weak(seen, seen + 1, std::memory_order_acquire, std::memory_order_relaxed))
+        {
+            std::atomic_thread_fence(std::memory_order_release);
+            return;
+        }
+
+        cuckoo::cpuRelax();
+    }
+}
+
+/* unlockStripe()
+*
+*  makes the version even again (and different from before the lock), publishing the writes made under it
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket>
+void ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::unlockStripe(std::size_t stripe) const
+{
+    stripes[stripe].version.fetch_add(1, std::memory_order_release);
+}
+
+/* tableOf()
+*
+*  table 1 or table 2 of a generation
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket>
+typename ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::Bucket *ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::tableOf(const Generation &gen, int whichTable)
+{
+    return whichTable == 1 ? gen.table1 : gen.table2;
+}
+
+/* freeRecords()
+*
+*  destroys every record of a generation and marks its slots free, keeping the tables' memory
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket>
+void ConcurrentCuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket>::freeRecords(Generation &gen)
+{
+    for (int t = 1; t <= 2; ++t)
+    {
+        Bucket *table = tableOf(gen, t);
+        for (std::size_t i = 0; i < gen.tableSize; ++i)
+        {
+            for (std::size_t s = 0; s < SlotsPerBucket; ++s)
+            {
+                if (table[i].tags[s].load(std::memory_order_relaxed) != cuckoo::EMPTY_TAG)
+                {
+                    eraseSlot(table[i], static_cast<int>(s));
+                }
+            }
+        }
+    }
+}
+
+#endif // CONCURRENTCUCKOOHASH_HPP_INCLUDED
@@ -0,0 +1,450 @@
+/*
+    Data Structures
+    Project Hash: Cuckoo Hashing
+    Author: Anthony Lupica <arl127@uakron.edu> 2022
+
+    Header file for the cuckoo::CuckooFilter class template, an approximate set of keys that
+    stores a small fingerprint per key instead of the key itself.
+
+    Ex.] Names Seen Before
+    cuckoo::CuckooFilter<std::string> seen(1000000);
+    seen.insert("Brad Pitt");
+    seen.contains("Brad Pitt");      // true
+    seen.contains("Tom Brady");      // false, except with probability about false_positive_rate()
+
+    contains() never misses a key that was inserted, and wrongly reports one that was not with
+    probability about 2 * FILTER_SLOTS * load_factor() / (2^FingerprintBits - 1): 8-bit fingerprints
+    (one byte per slot) answer about 3% of absent keys wrongly at 90% load, 16-bit ones (two bytes per
+    slot) about 0.01%. cuckoo::filterBitsFor() picks the fingerprint width for a target rate.
+
+    The filter is a cuckoo table of its own (partial-key cuckoo hashing, after Fan et al.): two tables
+    of FILTER_SLOTS fingerprints per bucket folded into one array, in which a key may live in one of two
+    buckets. The second bucket is the first one xor a hash of the fingerprint alone, so a fingerprint
+    can be moved to its other bucket without knowing its key, and remove() deletes a key again (which a
+    Bloom filter cannot). Insertion searches breadth-first for a displacement path, as CuckooHash does,
+    and keeps the few fingerprints without one in a small stash. A full filter refuses the insert.
+
+    Fingerprint and bucket are cut from different bits of one cuckoo::Hash code (finalized with
+    cuckoo::mixInt() for a non-avalanching Hasher, as CuckooHash does), so a CuckooHash and a filter
+    with the same Hasher agree on the hash code of every key. A CuckooHash keeps such a filter itself
+    after set_filter(true), and then answers most lookups of absent keys from it.
+*/
+
+#ifndef CUCKOOFILTER_HPP_INCLUDED
+#define CUCKOOFILTER_HPP_INCLUDED
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <type_traits>
+#include <vector>
+
+#include "CuckooHasher.hpp"
+
+namespace cuckoo
+{
+    // fingerprints per bucket of a CuckooFilter
+    const std::size_t FILTER_SLOTS = 4;
+
+    // the load a CuckooFilter is sized for. Four-slot buckets still find displacement paths just above it
+    const double FILTER_MAX_LOAD = 0.9;
+
+    // most moves one displacement path of a CuckooFilter may take
+    const std::size_t FILTER_MAX_PATH_LENGTH = 5;
+
+    // most buckets one displacement path search of a CuckooFilter may visit
+    const std::size_t FILTER_SEARCH_BUCKETS = 512;
+
+    // fingerprints a CuckooFilter stashes before refusing inserts
+    const std::size_t FILTER_STASH_SIZE = 4;
+
+    /* filterBitsFor()
+    *
+    *  the fewest fingerprint bits (4 to 16) for which a full CuckooFilter's false positive rate stays
+    *  below rate, e.g. cuckoo::CuckooFilter<Key, cuckoo::filterBitsFor(0.001)>
+    */
+    constexpr std::size_t filterBitsFor(double rate)
+    {
+        std::size_t bits = 4;
+        while (bits < 16 && 2.0 * FILTER_SLOTS / static_cast<double>((std::uint32_t(1) << bits) - 1) > rate)
+        {
+            ++bits;
+        }
+
+        return bits;
+    }
+
+    template <typename Key, std::size_t FingerprintBits = 8, typename Hasher = Hash<Key>>
+    class CuckooFilter
+    {
+        static_assert(FingerprintBits >= 4 && FingerprintBits <= 16, "FingerprintBits must be between 4 and 16");
+
+        private:
+
+            // one byte per fingerprint up to 8 bits, two above
+            using Fingerprint = std::conditional_t<FingerprintBits <= 8, std::uint8_t, std::uint16_t>;
+
+            // the fingerprint of a free slot. Fingerprints of keys are never 0
+            static constexpr Fingerprint EMPTY = 0;
+
+            static constexpr std::uint64_t FINGERPRINT_MASK = (std::uint64_t(1) << FingerprintBits) - 1;
+
+            // one bucket visited by the displacement path search, as in CuckooHash
+            struct PathNode
+            {
+                std::size_t bucket; // bucket index
+                std::size_t parent; // node whose fingerprint moves into this bucket (NO_PARENT for the key's own buckets)
+                std::size_t depth;  // number of moves from the key's own bucket to this one
+                int slot;           // slot of the parent bucket holding the fingerprint that moves here
+            };
+
+            static constexpr std::size_t NO_PARENT = static_cast<std::size_t>(-1);
+
+            // private data members
+            std::vector<Fingerprint> slots;               // bucketCount buckets of FILTER_SLOTS fingerprints
+            std::size_t bucketCount;                      // a power of two, so that alternate() can xor bucket indexes
+            std::size_t count;                            // fingerprints stored, in the buckets and the stash
+            Fingerprint stashFingerprints[FILTER_STASH_SIZE]; // fingerprints without a displacement path (EMPTY marks a free entry)
+            std::size_t stashBuckets[FILTER_STASH_SIZE];  // the first bucket of each stashed fingerprint
+            std::size_t stashCount;                       // number of stashed fingerprints
+            std::vector<PathNode> pathQueue;              // the displacement path search's queue, kept to reuse its memory
+            Hasher hasher;                                // hash function object
+
+            // private methods
+            Fingerprint fingerprintOf(std::uint64_t hashCode) const  // bits 8 and up of the hash code's low half, never EMPTY
+            {
+                Fingerprint fingerprint = static_cast<Fingerprint>((hashCode >> 8) & FINGERPRINT_MASK);
+                return fingerprint == EMPTY ? 1 : fingerprint;
+            }
+            std::size_t bucketOf(std::uint64_t hashCode) const       // the first bucket, from the hash code's high half
+            { return static_cast<std::size_t>(hashCode >> 32) & (bucketCount - 1); }
+            std::size_t alternate(std::size_t bucket, Fingerprint fingerprint) const // the other bucket of a fingerprint in bucket
+            { return (bucket ^ static_cast<std::size_t>(fingerprint * 0x5bd1e995ULL)) & (bucketCount - 1); }
+            Fingerprint *bucketAt(std::size_t bucket)
+            { return slots.data() + bucket * FILTER_SLOTS; }
+            const Fingerprint *bucketAt(std::size_t bucket) const
+            { return slots.data() + bucket * FILTER_SLOTS; }
+            static int findSlot(const Fingerprint *bucket, Fingerprint fingerprint); // slot holding fingerprint (EMPTY: a free slot), or -1
+            std::size_t findPath(std::size_t first, std::size_t second, int &slot); // breadth-first search for a free slot reachable by displacements
+            bool onPath(std::size_t node, std::size_t bucket) const;  // true when a bucket already lies on the path to node
+            void refillFromStash();                                  // moves stashed fingerprints into free slots of their buckets
+
+        public:
+
+            // ctors
+            explicit CuckooFilter(std::size_t capacity = 0);   // a filter sized for capacity keys at FILTER_MAX_LOAD
+
+            // public methods
+            template <typename K>
+            std::uint64_t hash_code(const K &key) const         // the hash code the filter derives bucket and fingerprint from
+            {
+                if constexpr (is_avalanching<Hasher>::value)
+                {
+                    return static_cast<std::uint64_t>(hasher(key));
+                }
+                else
+                {
+                    return mixInt(static_cast<std::uint64_t>(hasher(key)), DEFAULT_SEED);
+                }
+            }
+            bool insert(const Key &key)                         // add a key, false (adding nothing) when the filter is full
+            { return insert_hash(hash_code(key)); }
+            bool contains(const Key &key) const                 // true if the key may have been inserted, false if it surely was not
+            { return contains_hash(hash_code(key)); }
+            bool remove(const Key &key)                         // remove a key inserted before, false if its fingerprint was not found
+            { return remove_hash(hash_code(key)); }
+            bool insert_hash(std::uint64_t hashCode);           // insert() by hash code
+            bool contains_hash(std::uint64_t hashCode) const;   // contains() by hash code
+            bool remove_hash(std::uint64_t hashCode);           // remove() by hash code
+            void clear();                                       // remove every key, keeping the capacity
+            std::size_t size() const                            // getter for the number of fingerprints stored
+            { return count; }
+            std::size_t capacity() const                        // getter for the number of fingerprint slots
+            { return slots.size(); }
+            double load_factor() const                          // fraction of the slots holding a fingerprint
+            { return static_cast<double>(count) / static_cast<double>(slots.size()); }
+            double false_positive_rate() const;                 // expected fraction of absent keys contains() reports at the current load
+            std::size_t memory_bytes() const                    // bytes of the fingerprint array
+            { return slots.size() * sizeof(Fingerprint); }
+    };
+
+    /* capacity Constructor
+    *
+    *  the fewest buckets, a power of two, that hold capacity fingerprints at FILTER_MAX_LOAD (at least one)
+    */
+    template <typename Key, std::size_t FingerprintBits, typename Hasher>
+    CuckooFilter<Key, FingerprintBits, Hasher>::CuckooFilter(std::size_t capacity)
+        : bucketCount(1), count(0), stashFingerprints(), stashBuckets(), stashCount(0)
+    {
+        std::size_t neededBuckets = static_cast<std::size_t>(std::ceil(static_cast<double>(capacity) / (FILTER_SLOTS * FILTER_MAX_LOAD)));
+        while (bucketCount < neededBuckets)
+        {
+            bucketCount <<= 1;
+        }
+        slots.assign(bucketCount * FILTER_SLOTS, EMPTY);
+    }
+
+    /* insert_hash()
+    *
+    *  stores the key's fingerprint in a free slot of its first or second bucket, else at the start of
+    *  a displacement path, else in the stash. Returns false, storing nothing, when all three are full.
+    *  Inserting a key twice stores its fingerprint twice, so that removing it once keeps the other.
+    */
+    template <typename Key, std::size_t FingerprintBits, typename Hasher>
+    bool CuckooFilter<Key, FingerprintBits, Hasher>::insert_hash(std::uint64_t hashCode)
+    {
+        Fingerprint fingerprint = fingerprintOf(hashCode);
+        std::size_t first = bucketOf(hashCode);
+
+        int slot = -1;
+        std::size_t node = findPath(first, alternate(first, fingerprint), slot);
+        if (node == NO_PARENT)
+        {
+            for (std::size_t s = 0; s < FILTER_STASH_SIZE; ++s)
+            {
+                if (stashFingerprints[s] == EMPTY)
+                {
+                    stashFingerprints[s] = fingerprint;
+                    stashBuckets[s] = first;
+                    ++stashCount;
+                    ++count;
+
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        // walk the path back from its free slot, moving each fingerprint one bucket forward
+        while (pathQueue[node].parent != NO_PARENT)
+        {
+            const PathNode &to = pathQueue[node];
+            Fingerprint *source = bucketAt(pathQueue[to.parent].bucket);
+            bucketAt(to.bucket)[slot] = source[to.slot];
+            source[to.slot] = EMPTY;
+
+            slot = to.slot;
+            node = to.parent;
+        }
+
+        bucketAt(pathQueue[node].bucket)[slot] = fingerprint;
+        ++count;
+
+        return true;
+    }
+
+    /* contains_hash()
+    *
+    *  true if the key's fingerprint is in one of its two buckets, or stashed
+    */
+    template <typename Key, std::size_t FingerprintBits, typename Hasher>
+    bool CuckooFilter<Key, FingerprintBits, Hasher>::contains_hash(std::uint64_t hashCode) const
+    {
+        Fingerprint fingerprint = fingerprintOf(hashCode);
+        std::size_t first = bucketOf(hashCode);
+
+        if (findSlot(bucketAt(first), fingerprint) != -1 || findSlot(bucketAt(alternate(first, fingerprint)), fingerprint) != -1)
+        {
+            return true;
+        }
+
+        // the stash is only searched while it holds fingerprints
+        if (stashCount > 0)
+        {
+            for (std::size_t s = 0; s < FILTER_STASH_SIZE; ++s)
+            {
+                if (stashFingerprints[s] == fingerprint && stashBuckets[s] == first)
+                {
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    /* remove_hash()
+    *
+    *  deletes one copy of the key's fingerprint. Only keys that were inserted may be removed: the
+    *  fingerprint of an absent key may belong to another key, which would then be missed.
+    */
+    template <typename Key, std::size_t FingerprintBits, typename Hasher>
+    bool CuckooFilter<Key, FingerprintBits, Hasher>::remove_hash(std::uint64_t hashCode)
+    {
+        Fingerprint fingerprint = fingerprintOf(hashCode);
+        std::size_t first = bucketOf(hashCode);
+
+        for (std::size_t bucket : { first, alternate(first, fingerprint) })
+        {
+            int slot = findSlot(bucketAt(bucket), fingerprint);
+            if (slot != -1)
+            {
+                bucketAt(bucket)[slot] = EMPTY;
+                --count;
+
+                // the freed slot may be the one a stashed fingerprint was missing
+                if (stashCount > 0)
+                {
+                    refillFromStash();
+                }
+
+                return true;
+            }
+        }
+
+        for (std::size_t s = 0; s < FILTER_STASH_SIZE && stashCount > 0; ++s)
+        {
+            if (stashFingerprints[s] == fingerprint && stashBuckets[s] == first)
+            {
+                stashFingerprints[s] = EMPTY;
+                --stashCount;
+                --count;
+
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /* clear()
+    *
+    *  empties every bucket and the stash
+    */
+    template <typename Key, std::size_t FingerprintBits, typename Hasher>
+    void CuckooFilter<Key, FingerprintBits, Hasher>::clear()
+    {
+        std::fill(slots.begin(), slots.end(), EMPTY);
+        for (Fingerprint &fingerprint : stashFingerprints)
+        {
+            fingerprint = EMPTY;
+        }
+        stashCount = 0;
+        count = 0;
+    }
+
+    /* false_positive_rate()
+    *
+    *  an absent key is reported when one of the up to 2 * FILTER_SLOTS fingerprints of its buckets
+    *  matches its own, each with probability 1 / (2^FingerprintBits - 1)
+    */
+    template <typename Key, std::size_t FingerprintBits, typename Hasher>
+    double CuckooFilter<Key, FingerprintBits, Hasher>::false_positive_rate() const
+    {
+        double compared = 2.0 * FILTER_SLOTS * load_factor();
+
+        return 1.0 - std::pow(1.0 - 1.0 / static_cast<double>(FINGERPRINT_MASK), compared);
+    }
+
+    /* findSlot()
+    *
+    *  the first slot of bucket holding fingerprint, or -1. Searching for EMPTY finds a free slot.
+    */
+    template <typename Key, std::size_t FingerprintBits, typename Hasher>
+    int CuckooFilter<Key, FingerprintBits, Hasher>::findSlot(const Fingerprint *bucket, Fingerprint fingerprint)
+    {
+        for (std::size_t s = 0; s < FILTER_SLOTS; ++s)
+        {
+            if (bucket[s] == fingerprint)
+            {
+                return static_cast<int>(s);
+            }
+        }
+
+        return -1;
+    }
+
+    /* findPath()
+    *
+    *  breadth-first search from a key's two buckets, as CuckooHash::findPath() does: a bucket with a
+    *  free slot ends the search, and a full one queues the other bucket of each of its fingerprints, up
+    *  to FILTER_MAX_PATH_LENGTH moves deep and FILTER_SEARCH_BUCKETS buckets in all. Returns the node
+    *  of the bucket with the free slot (and the free slot in slot), or NO_PARENT. Nothing is moved.
+    */
+    template <typename Key, std::size_t FingerprintBits, typename Hasher>
+    std::size_t CuckooFilter<Key, FingerprintBits, Hasher>::findPath(std::size_t first, std::size_t second, int &slot)
+    {
+        pathQueue.clear();
+        pathQueue.push_back(PathNode{ first, NO_PARENT, 0, -1 });
+        pathQueue.push_back(PathNode{ second, NO_PARENT, 0, -1 });
+
+        for (std::size_t head = 0; head < pathQueue.size(); ++head)
+        {
+            PathNode current = pathQueue[head];
+            const Fingerprint *bucket = bucketAt(current.bucket);
+
+            slot = findSlot(bucket, EMPTY);
+            if (slot != -1)
+            {
+                return head;
+            }
+
+            if (current.depth >= FILTER_MAX_PATH_LENGTH)
+            {
+                continue;
+            }
+
+            for (std::size_t s = 0; s < FILTER_SLOTS && pathQueue.size() < FILTER_SEARCH_BUCKETS; ++s)
+            {
+                std::size_t otherBucket = alternate(current.bucket, bucket[s]);
+                if (!onPath(head, otherBucket))
+                {
+                    pathQueue.push_back(PathNode{ otherBucket, head, current.depth + 1, static_cast<int>(s) });
+                }
+            }
+        }
+
+        return NO_PARENT;
+    }
+
+    /* onPath()
+    *
+    *  returns true if the bucket is node's own bucket or one of the buckets on the path leading to it
+    */
+    template <typename Key, std::size_t FingerprintBits, typename Hasher>
+    bool CuckooFilter<Key, FingerprintBits, Hasher>::onPath(std::size_t node, std::size_t bucket) const
+    {
+        for (; node != NO_PARENT; node = pathQueue[node].parent)
+        {
+            if (pathQueue[node].bucket == bucket)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /* refillFromStash()
+    *
+    *  moves each stashed fingerprint into a free slot of one of its two buckets, where there is one
+    */
+    template <typename Key, std::size_t FingerprintBits, typename Hasher>
+    void CuckooFilter<Key, FingerprintBits, Hasher>::refillFromStash()
+    {
+        for (std::size_t s = 0; s < FILTER_STASH_SIZE; ++s)
+        {
+            if (stashFingerprints[s] == EMPTY)
+            {
+                continue;
+            }
+
+            for (std::size_t bucket : { stashBuckets[s], alternate(stashBuckets[s], stashFingerprints[s]) })
+            {
+                int slot = findSlot(bucketAt(bucket), EMPTY);
+                if (slot != -1)
+                {
+                    bucketAt(bucket)[slot] = stashFingerprints[s];
+                    stashFingerprints[s] = EMPTY;
+                    --stashCount;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+#endif // CUCKOOFILTER_HPP_INCLUDED
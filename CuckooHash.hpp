@@ -3,80 +3,2741 @@
     Project Hash: Cuckoo Hashing
     Author: Anthony Lupica <arl127@uakron.edu> 2022
 
-    Header file for a hash table class using the cuckoo hashing technique.
+    Header file for a hash table class template using the cuckoo hashing technique.
+
+    The hash table implements a key - value pair lookup. The key type, value type,
+    hash function and key equality are all template parameters, so the same table
+    serves a name - year lookup as well as integer or fixed-width ids.
 
-    The hash table implements a name - year pair lookup. The name of a person 
-    can be used as the key to quickly find an associated year.
-    
     Ex.] Birth Year
-    std::cout << CuckooHash.search("Brad Pitt");
+    CuckooHash<std::string, int> birthYears;
+    birthYears.insert("Brad Pitt", 1963);
+    std::cout << *birthYears.search("Brad Pitt");
         --> "1963"
-    
-    The user may decide which logical assiocation to use between names and years.
+
+    Keys are hashed once per operation by the Hasher (cuckoo::Hash by default, see
+    CuckooHasher.hpp). The low 32 bits of that hash code select the table 1 position, the high
+    32 bits select the table 2 position, and the lowest byte doubles as the slot's fingerprint.
+    When the Hasher and KeyEqual are both transparent, as the defaults for std::string keys are,
+    search(), contains() and remove() also take any key type they accept, e.g. a std::string_view
+    or a string literal, without constructing a Key.
+
+    Each hash position of the tables is a bucket of SlotsPerBucket slots. With the
+    default of 1 slot this is the classic one-record-per-position cuckoo table, which has to
+    grow at half load. With 4 to 8 slots per bucket (a set-associative layout) the tables
+    comfortably run at 90% load. Every slot carries an 8-bit fingerprint tag, and a lookup
+    compares all tags of a bucket at once, touching a full key only on a tag hit.
+
+    By default (cuckoo::Layout::AoS) a bucket holds its tags followed by its records. With
+    cuckoo::Layout::SoA as the last template parameter, each table instead keeps the tags of all
+    buckets, all keys and all values in three parallel arrays. The dense tag array stays in cache far
+    longer, so lookups of absent keys, which never get past the tags, cost much less memory traffic,
+    while a hit reads one more cache line (its key and its value sit in different arrays).
+
+    The TableCount template parameter (2 by default) sets the number of tables, and so of hash
+    functions: a key may live in one bucket of each, and a lookup probes them in order in a loop the
+    compiler unrolls. Tables beyond the second are positioned by the two halves of the hash code
+    combined (double hashing). More choices let a table run fuller: with 3 or 4 tables even single-slot
+    buckets reach 85 to 90% load, at the price of up to TableCount probes for an absent key.
+
+    The tables' memory comes from the Allocator template parameter, any standard allocator (rebound to
+    cache lines). The default cuckoo::ZeroedAllocator takes it from calloc(), whose fresh pages are zero
+    already. An allocator that declares an "is_zeroing" member type promises the same; the memory of
+    any other is cleared by the table. cuckoo::HugePageAllocator (HugePageAllocator.hpp) backs large
+    tables with 2 MiB pages and keeps the tables a rehash frees for the next one.
+    cuckoo::NumaAllocator (NumaAllocator.hpp) interleaves them over the NUMA nodes or places them on one.
+
+    Growth either rehashes every record before the triggering insert() returns, or (after
+    set_incremental_resize(true)) keeps the previous generation of tables alive and migrates
+    MIGRATE_BUCKETS of its buckets on every insert(), search() and remove() until it is empty.
+    Lookups consult both generations while a migration is in progress.
+
+    When and how far the tables resize is set by a cuckoo::LoadPolicy (set_load_policy()): the load
+    at which insert() grows them, the factor they grow by, and the load below which remove() shrinks
+    them again, to about half the maximum load. The default shrinks at SHRINK_LOAD_FRACTION of the
+    maximum load, so a table that held millions of records for a while does not keep their memory
+    once they are removed. shrink_to_fit() rehashes to the smallest tables that hold the records.
+
+    build() bulk loads a batch of pairs, and rehash() moves records, in passes over disjoint bucket
+    ranges, one range per thread (thread_count() of them for large batches): first into free slots of
+    each record's table 1 bucket, then of its table 2 bucket and so on, and only the few records left
+    over go through the displacement search one at a time. A caller that hashes the keys itself (as
+    cuckoo::load_file() does on its parsing threads, see CuckooLoader.hpp) passes their hash_code()s along.
+
+    When all buckets of a new key are full, insert() searches breadth-first (as libcuckoo does)
+    for the shortest chain of displacements that ends in a free slot, at most max_path_length()
+    moves long, and only then shifts the records along that chain. A record without such a path
+    goes to a small stash of STASH_SIZE records, which lookups check after the tables, and only
+    a full stash grows the tables. Stashed records move back into the tables as room frees up.
+
+    search_batch() and contains_batch() look up many keys at once: they hash a group of
+    BATCH_GROUP keys, prefetch both candidate buckets of each, and only then compare, so the
+    memory latency of the whole group overlaps instead of costing two misses per key in turn.
+
+    insert_batch(), upsert_batch() and remove_batch() do the same for writes, and report what happened
+    to each record as a cuckoo::Status instead of writing to std::cerr as insert() and remove() do.
+    insert_or_assign() is the single-record upsert: it replaces the value of a key that exists.
+
+    After set_filter(true), a table also keeps a cuckoo::CuckooFilter (CuckooFilter.hpp) of its keys,
+    a byte per key that stays cached when the tables do not, and consults it before probing them.
+    Lookups of absent keys, and the uniqueness check of insert(), then mostly end in the filter.
+
+    stats() reports the occupancy of the tables. Compiled with CUCKOO_STATS defined to 1 (the CMake
+    option of the same name), every table also counts what its operations did: hits and misses with
+    the buckets they probed, stash hits, refused duplicates, a histogram of displacement path lengths,
+    rehashes and their duration, and a histogram of insert() latencies (see cuckoo::Metrics). Without
+    it the counters are an empty object whose members do nothing, so they cost nothing. Define
+    CUCKOO_STATS the same way in every translation unit, as it changes the class layout.
+
+    The class is header-only: every member is defined below the class declaration.
 */
 
 #ifndef CUCKOOHASH_HPP_INCLUDED
 #define CUCKOOHASH_HPP_INCLUDED
 
-#include <string>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <cstdlib>
+#include <limits>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "CuckooHasher.hpp"
+#include "CuckooFilter.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// 1 to have every CuckooHash count its lookups, displacements, rehashes and insert latencies for stats()
+#ifndef CUCKOO_STATS
+#define CUCKOO_STATS 0
+#endif
+
+namespace cuckoo
+{
+    // number of buckets per table of a new CuckooHash
+    const std::size_t INITIAL_TABLE_SIZE = 16;
+
+    // the tables double in size on every growth (unless a LoadPolicy says otherwise)
+    const std::size_t GROWTH_FACTOR = 2;
+
+    // by default, remove() shrinks the tables once their load drops below this fraction of the maximum load
+    const double SHRINK_LOAD_FRACTION = 0.125;
+
+    // previous-generation buckets (of each table) migrated per operation during an incremental resize
+    const std::size_t MIGRATE_BUCKETS = 4;
+
+    // largest number of buckets per table. Positions are mapped from 32-bit halves of the hash code,
+    // which bounds a table just below 2^32 buckets (far beyond what memory allows for any realistic record)
+    const std::size_t MAX_TABLE_SIZE = std::numeric_limits<std::uint32_t>::max();
+
+    // most buckets one displacement path search may visit, which bounds the work of a failed search
+    // however many slots a bucket has
+    const std::size_t MAX_SEARCH_BUCKETS = 2048;
+
+    // fewest records for which build() and rehash() split their passes across threads
+    const std::size_t PARALLEL_MIN_RECORDS = 1 << 16;
+
+    // keys search_batch() and contains_batch() hash and prefetch before resolving any of them
+    const std::size_t BATCH_GROUP = 16;
+
+    // records the stash holds before a failed displacement path search grows the tables
+    const std::size_t STASH_SIZE = 8;
+
+    // the size of a cache line, used to align multi-slot buckets
+    const std::size_t CACHE_LINE = 64;
+
+    // fingerprint bits of the CuckooFilter a CuckooHash keeps after set_filter(true): one byte per slot,
+    // small enough to stay cached long after the tables are not
+    const std::size_t TABLE_FILTER_BITS = 8;
+
+    // most tables (hash functions) a CuckooHash may have
+    const std::size_t MAX_TABLE_COUNT = 8;
+
+    // the tag value of a free slot. Fingerprints of stored keys are never 0
+    const std::uint8_t EMPTY_TAG = 0;
 
-using std::string;
+    // displacement path lengths Metrics tells apart. Longer paths share the last bin
+    const std::size_t PATH_HISTOGRAM_BINS = 16;
 
-// the defined size declarator for PRIME_LIST (increase or decrease when adding or removing elements from PRIME_LIST)
-const int LENGTH_PRIME = 13; 
+    // insert() latency classes of Metrics: class i counts calls of 2^i to 2^(i + 1) - 1 nanoseconds
+    const std::size_t LATENCY_HISTOGRAM_BINS = 40;
 
-// list of prime numbers beginning at 11 for table sizes. Double and round up to nearest prime
-const int PRIME_LIST[LENGTH_PRIME] = { 11, 23, 47, 97, 197, 397, 797, 1597, 3203, 6421, 12853, 25717, 51481 };
+    // what a CuckooHash compiled with CUCKOO_STATS counted since it was constructed (all zero without)
+    struct Metrics
+    {
+        std::size_t hits;                                 // lookups (search(), contains() and the batch versions) that found their key
+        std::size_t misses;                               // lookups that did not
+        std::size_t probes;                               // buckets and stash scans those lookups examined
+        std::size_t stashHits;                            // lookups answered by the stash
+        std::size_t filterRejects;                        // misses the filter answered without probing the tables (see set_filter())
+        std::size_t duplicates;                           // insert() calls refused because the key existed
+        std::size_t pathLengths[PATH_HISTOGRAM_BINS];     // placements by the number of displacements they took (0: a free slot of an own bucket)
+        std::size_t pathFailures;                         // displacement searches without a path, after which the record was stashed or the tables grew
+        std::size_t rehashes;                             // rehash() passes
+        std::size_t migrations;                           // incremental resizes started
+        std::uint64_t rehashNanoseconds;                  // time spent in rehash() passes
+        std::uint64_t longestRehashNanoseconds;           // the longest of them
+        std::size_t insertLatency[LATENCY_HISTOGRAM_BINS]; // inserts by duration class (insert(), emplace(), insert_or_assign(), and each record of a batch)
 
+        double probes_per_lookup() const                  // mean buckets examined per lookup
+        { return hits + misses == 0 ? 0.0 : static_cast<double>(probes) / static_cast<double>(hits + misses); }
+        double miss_ratio() const                         // fraction of lookups that did not find their key
+        { return hits + misses == 0 ? 0.0 : static_cast<double>(misses) / static_cast<double>(hits + misses); }
+    };
+
+    /* Instruments
+    *
+    *  the counters behind Metrics, which a CuckooHash feeds from its operations. Instruments<false>, what
+    *  a table holds unless CUCKOO_STATS is 1, is empty and its members do nothing, so the calls compile away
+    */
+    template <bool Enabled>
+    struct Instruments
+    {
+        using Clock = std::chrono::steady_clock;
+
+        Metrics metrics = Metrics();
+
+        static Clock::time_point now()
+        { return Clock::now(); }
+        static std::uint64_t nanosecondsSince(Clock::time_point started)
+        { return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - started).count()); }
+
+        void lookup(bool found, std::size_t probes, bool stashHit)
+        {
+            ++(found ? metrics.hits : metrics.misses);
+            metrics.probes += probes;
+            metrics.stashHits += stashHit ? 1 : 0;
+        }
+        void filterReject()
+        {
+            ++metrics.misses;
+            ++metrics.filterRejects;
+        }
+        void duplicate()
+        { ++metrics.duplicates; }
+        void path(std::size_t moves)
+        { ++metrics.pathLengths[moves < PATH_HISTOGRAM_BINS ? moves : PATH_HISTOGRAM_BINS - 1]; }
+        void pathFailure()
+        { ++metrics.pathFailures; }
+        void migration()
+        { ++metrics.migrations; }
+        void rehash(Clock::time_point started)
+        {
+            std::uint64_t nanoseconds = nanosecondsSince(started);
+            ++metrics.rehashes;
+            metrics.rehashNanoseconds += nanoseconds;
+            metrics.longestRehashNanoseconds = std::max(metrics.longestRehashNanoseconds, nanoseconds);
+        }
+        void insert(Clock::time_point started)
+        {
+            std::size_t latencyClass = 0;
+            for (std::uint64_t nanoseconds = nanosecondsSince(started); nanoseconds > 1 && latencyClass < LATENCY_HISTOGRAM_BINS - 1; nanoseconds >>= 1)
+            {
+                ++latencyClass;
+            }
+            ++metrics.insertLatency[latencyClass];
+        }
+        Metrics snapshot() const
+        { return metrics; }
+    };
+
+    template <>
+    struct Instruments<false>
+    {
+        static int now()
+        { return 0; }
+
+        void lookup(bool, std::size_t, bool) {}
+        void filterReject() {}
+        void duplicate() {}
+        void path(std::size_t) {}
+        void pathFailure() {}
+        void migration() {}
+        void rehash(int) {}
+        void insert(int) {}
+        Metrics snapshot() const
+        { return Metrics(); }
+    };
+
+    // when a CuckooHash resizes its tables
+    struct LoadPolicy
+    {
+        double maxLoadFactor;    // insert() grows the tables at this load (0 < maxLoadFactor <= 1)
+        double growthFactor;     // they grow to this many times their size (> 1)
+        double shrinkLoadFactor; // remove() shrinks them below this load (below maxLoadFactor / growthFactor, 0 never shrinks)
+    };
+
+    // how a CuckooHash lays out the slots of a table
+    enum class Layout
+    {
+        AoS, // an array of buckets, each holding its slots' tags followed by their records
+        SoA  // three parallel arrays: every slot's tag, then every key, then every value
+    };
+
+    // what a write did to one record, as insert_or_assign() and the batch writes report it
+    enum class Status : std::uint8_t
+    {
+        Inserted, // the key was absent, and its record was added
+        Assigned, // the key was present, and its value was replaced (insert_or_assign() and upsert_batch())
+        Exists,   // the key was present, and the table is unchanged (insert_batch())
+        Removed,  // the key's record was removed (remove_batch())
+        Missing,  // the key was absent, and the table is unchanged (remove_batch())
+        Failed    // the tables could not grow to take the record
+    };
+
+    /* maxPathLength()
+    *
+    *  the longest displacement path searched in tableCount tables of slotsPerBucket slots per bucket.
+    *  Each level of the search fans out by slotsPerBucket * (tableCount - 1), and paths stay short once
+    *  it branches. One slot in each of two tables makes the search a single chain per table, which may run longer.
+    */
+    constexpr std::size_t maxPathLength(std::size_t slotsPerBucket, std::size_t tableCount)
+    {
+        return slotsPerBucket * (tableCount - 1) == 1 ? 64 : (slotsPerBucket * (tableCount - 1) == 2 ? 8 : 5);
+    }
+
+    /* maxLoadFactor()
+    *
+    *  the load at which tableCount tables of slotsPerBucket slots per bucket grow by default. One slot per
+    *  position in two tables has to stay near half full for evictions to terminate, while multi-slot
+    *  buckets, and more tables, absorb collisions and run much fuller.
+    */
+    constexpr double maxLoadFactor(std::size_t slotsPerBucket, std::size_t tableCount)
+    {
+        return tableCount == 2
+            ? (slotsPerBucket >= 4 ? 0.9 : (slotsPerBucket >= 2 ? 0.8 : 0.5))
+            : (slotsPerBucket >= 2 ? 0.95 : (tableCount == 3 ? 0.85 : 0.9));
+    }
+
+    /* allocateZeroed()
+    *
+    *  returns bytes of zeroed memory aligned to alignment (a power of two). The memory comes from
+    *  calloc(), which for large blocks hands out fresh pages from the OS without touching them,
+    *  so allocating a big table costs no more than a small one until its pages are first used.
+    *  The block calloc() returned is remembered just below the aligned pointer.
+    */
+    inline void *allocateZeroed(std::size_t bytes, std::size_t alignment)
+    {
+        void *block = std::calloc(1, bytes + alignment + sizeof(void *));
+        if (block == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+
+        std::uintptr_t aligned = (reinterpret_cast<std::uintptr_t>(block) + sizeof(void *) + alignment - 1) & ~(alignment - 1);
+        reinterpret_cast<void **>(aligned)[-1] = block;
+
+        return reinterpret_cast<void *>(aligned);
+    }
+
+    /* freeZeroed()
+    *
+    *  releases memory returned by allocateZeroed()
+    */
+    inline void freeZeroed(void *memory)
+    {
+        if (memory != nullptr)
+        {
+            std::free(reinterpret_cast<void **>(memory)[-1]);
+        }
+    }
+
+    // the unit a CuckooHash allocates its tables in, so that every table starts on a cache line
+    struct alignas(CACHE_LINE) CacheLine
+    {
+        unsigned char bytes[CACHE_LINE];
+    };
+
+    /* ZeroedAllocator
+    *
+    *  the default Allocator of CuckooHash: allocateZeroed() as a standard allocator. It declares
+    *  "is_zeroing", promising that the memory it hands out reads as zero, so a new table needs no clearing
+    */
+    template <typename T>
+    struct ZeroedAllocator
+    {
+        using value_type = T;
+        using is_zeroing = void;
+
+        ZeroedAllocator() = default;
+        template <typename U>
+        ZeroedAllocator(const ZeroedAllocator<U> &) {}
+
+        T *allocate(std::size_t n)
+        { return static_cast<T *>(allocateZeroed(n * sizeof(T), alignof(T) > alignof(std::max_align_t) ? alignof(T) : alignof(std::max_align_t))); }
+        void deallocate(T *memory, std::size_t)
+        { freeZeroed(memory); }
+
+        template <typename U>
+        bool operator==(const ZeroedAllocator<U> &) const
+        { return true; }
+        template <typename U>
+        bool operator!=(const ZeroedAllocator<U> &) const
+        { return false; }
+    };
+
+    template <typename Allocator, typename = void>
+    struct is_zeroing : std::false_type {};
+
+    template <typename Allocator>
+    struct is_zeroing<Allocator, std::void_t<typename Allocator::is_zeroing>> : std::true_type {};
+
+    /* lowestSlot()
+    *
+    *  returns the index of the lowest set bit of a non-zero slot mask
+    */
+    inline int lowestSlot(std::uint32_t mask)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctz(mask);
+#endif
+    }
+
+    /* matchTags()
+    *
+    *  compares every tag of a bucket against tag and returns a mask with bit i set when
+    *  tags[i] == tag. 16 and 32 slot buckets use a single SSE2 / AVX2 byte compare, 4 and 8
+    *  slot buckets compare all tags inside one 64-bit word, and any other width falls back to a loop.
+    */
+    template <std::size_t Slots>
+    inline std::uint32_t matchTags(const std::uint8_t *tags, std::uint8_t tag)
+    {
+#if defined(__AVX2__)
+        if constexpr (Slots == 32)
+        {
+            __m256i lanes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(tags));
+            return static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lanes, _mm256_set1_epi8(static_cast<char>(tag)))));
+        }
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+        if constexpr (Slots == 16)
+        {
+            __m128i lanes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(tags));
+            return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(lanes, _mm_set1_epi8(static_cast<char>(tag)))));
+        }
+#endif
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) || defined(_M_X64)
+        if constexpr (Slots == 4 || Slots == 8)
+        {
+            const std::uint64_t LOW_SEVEN = 0x7F7F7F7F7F7F7F7FULL;
+
+            // xor leaves a zero byte exactly where a tag matches
+            std::uint64_t word = 0;
+            std::memcpy(&word, tags, Slots);
+            word ^= 0x0101010101010101ULL * tag;
+
+            // set the high bit of every zero byte (exact, no borrow between bytes),
+            // then gather the eight high bits into the low byte
+            std::uint64_t zeroBytes = ~(((word & LOW_SEVEN) + LOW_SEVEN) | word | LOW_SEVEN);
+            std::uint32_t mask = static_cast<std::uint32_t>(((zeroBytes >> 7) * 0x0102040810204080ULL) >> 56);
+
+            return mask & ((1u << Slots) - 1);
+        }
+#endif
+        std::uint32_t mask = 0;
+        for (std::size_t i = 0; i < Slots; ++i)
+        {
+            mask |= static_cast<std::uint32_t>(tags[i] == tag) << i;
+        }
+
+        return mask;
+    }
+
+    /* hash1()
+    *
+    *  position in table 1: the low half of the hash code, mapped over the size buckets with fastRange()
+    */
+    inline std::size_t hash1(std::uint64_t hashCode, std::size_t size)
+    {
+        return static_cast<std::size_t>(fastRange(static_cast<std::uint32_t>(hashCode), static_cast<std::uint32_t>(size)));
+    }
+
+    /* hash2()
+    *
+    *  position in table 2: the high half of the hash code, mapped over the size buckets with fastRange()
+    */
+    inline std::size_t hash2(std::uint64_t hashCode, std::size_t size)
+    {
+        return static_cast<std::size_t>(fastRange(static_cast<std::uint32_t>(hashCode >> 32), static_cast<std::uint32_t>(size)));
+    }
+
+    /* hashAt()
+    *
+    *  position in table "table" (1 to a CuckooHash's TableCount): hash1() and hash2() for the first
+    *  two tables, and low + (table - 1) * high of the hash code's halves for the tables beyond them
+    */
+    inline std::size_t hashAt(std::uint64_t hashCode, int table, std::size_t size)
+    {
+        std::uint32_t low = static_cast<std::uint32_t>(hashCode);
+        std::uint32_t high = static_cast<std::uint32_t>(hashCode >> 32);
+        std::uint32_t hash = table == 1 ? low : (table == 2 ? high : low + static_cast<std::uint32_t>(table - 1) * high);
+
+        return static_cast<std::size_t>(fastRange(hash, static_cast<std::uint32_t>(size)));
+    }
+
+    /* tagOf()
+    *
+    *  8-bit fingerprint of a key: the lowest byte of the hash code, which fastRange() barely uses
+    *  for either position. Never EMPTY_TAG.
+    */
+    inline std::uint8_t tagOf(std::uint64_t hashCode)
+    {
+        std::uint8_t tag = static_cast<std::uint8_t>(hashCode);
+
+        return tag == EMPTY_TAG ? 1 : tag;
+    }
+
+    /* prefetch()
+    *
+    *  hints the CPU to start loading the cache line at address
+    */
+    inline void prefetch(const void *address)
+    {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        _mm_prefetch(static_cast<const char *>(address), _MM_HINT_T0);
+#elif defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(address);
+#else
+        (void)address;
+#endif
+    }
+
+    /* runParallel()
+    *
+    *  calls task(part) for every part in [0, parts), each on its own thread (the calling thread takes
+    *  part 0), and returns once all of them have finished
+    */
+    template <typename Task>
+    void runParallel(std::size_t parts, Task task)
+    {
+        std::vector<std::thread> workers;
+        workers.reserve(parts);
+        for (std::size_t part = 1; part < parts; ++part)
+        {
+            workers.emplace_back(task, part);
+        }
+
+        task(0);
+
+        for (std::thread &worker : workers)
+        {
+            worker.join();
+        }
+    }
+}
+template <typename Key, typename Value, typename Hasher = cuckoo::Hash<Key>, typename KeyEqual = cuckoo::Equal<Key>, std::size_t SlotsPerBucket = 1,
+          cuckoo::Layout SlotLayout = cuckoo::Layout::AoS, std::size_t TableCount = 2, typename Allocator = cuckoo::ZeroedAllocator<unsigned char>>
 class CuckooHash
 {
+    static_assert(SlotsPerBucket >= 1 && SlotsPerBucket <= 32, "SlotsPerBucket must be between 1 and 32");
+    static_assert(TableCount >= 2 && TableCount <= cuckoo::MAX_TABLE_COUNT, "TableCount must be between 2 and MAX_TABLE_COUNT");
+
     private:
-       
-        struct HashNode 
+
+        struct HashNode
+        {
+            Key key;     // key
+            Value value; // value
+        };
+
+        // the storage of one record. Key and value are constructed separately, as they are in the
+        // parallel arrays of cuckoo::Layout::SoA
+        struct Slot
+        {
+            alignas(Key) unsigned char key[sizeof(Key)];       // storage of the key
+            alignas(Value) unsigned char value[sizeof(Value)]; // storage of the value
+        };
+
+        // one hash position of cuckoo::Layout::AoS: the tags come first so a probe only reads the bucket's
+        // first bytes before deciding whether any key is worth comparing. A slot's record is only constructed
+        // while its tag is set, so an all-zero bucket is a valid empty bucket and tables can be
+        // allocated as zeroed memory without running a constructor per slot.
+        struct alignas(SlotsPerBucket > 1 ? cuckoo::CACHE_LINE : alignof(Slot)) Bucket
+        {
+            std::uint8_t tags[SlotsPerBucket]; // fingerprint of each slot (EMPTY_TAG marks a free slot)
+            Slot slots[SlotsPerBucket];        // the records
+        };
+
+        // bytes from one key (or value) of a bucket to the next
+        static constexpr std::size_t KEY_STRIDE = SlotLayout == cuckoo::Layout::SoA ? sizeof(Key) : sizeof(Slot);
+        static constexpr std::size_t VALUE_STRIDE = SlotLayout == cuckoo::Layout::SoA ? sizeof(Value) : sizeof(Slot);
+
+        // a bucket of either layout, by the address of its first tag, key and value
+        struct BucketRef
         {
-            string name; // key 
-            int year;    // value 
+            std::uint8_t *tags;    // the bucket's SlotsPerBucket tags
+            unsigned char *keys;   // storage of the bucket's first key
+            unsigned char *values; // storage of the bucket's first value
+
+            Key &key(std::size_t slot) const
+            { return *std::launder(reinterpret_cast<Key *>(keys + slot * KEY_STRIDE)); }
+            Value &value(std::size_t slot) const
+            { return *std::launder(reinterpret_cast<Value *>(values + slot * VALUE_STRIDE)); }
+            template <typename K, typename V>
+            void construct(std::size_t slot, K &&key, V &&value) const // constructs a record in a free slot (the caller sets its tag)
+            {
+                new (keys + slot * KEY_STRIDE) Key(std::forward<K>(key));
+                new (values + slot * VALUE_STRIDE) Value(std::forward<V>(value));
+            }
         };
 
+        // one table. With cuckoo::Layout::AoS, memory is an array of Buckets. With cuckoo::Layout::SoA it
+        // holds the tags of every bucket back to back, followed by the key array and the value array, so
+        // probes scan dense tags and touch a key or value only on a tag hit.
+        struct Table
+        {
+            unsigned char *memory; // the zeroed allocation (nullptr for no table), tableLines() cache lines long
+            unsigned char *keys;   // cuckoo::Layout::SoA: start of the key array
+            unsigned char *values; // cuckoo::Layout::SoA: start of the value array
+
+            BucketRef operator[](std::size_t index) const
+            {
+                if constexpr (SlotLayout == cuckoo::Layout::SoA)
+                {
+                    return BucketRef{ memory + index * SlotsPerBucket, keys + index * SlotsPerBucket * sizeof(Key), values + index * SlotsPerBucket * sizeof(Value) };
+                }
+                else
+                {
+                    Bucket &bucket = reinterpret_cast<Bucket *>(memory)[index];
+                    return BucketRef{ bucket.tags, bucket.slots[0].key, bucket.slots[0].value };
+                }
+            }
+        };
+
+        // a record rehash() is about to move
+        struct RecordRef
+        {
+            Key *key;     // the record's key
+            Value *value; // the record's value
+        };
+
+        // the few records that found no displacement path. Searched after the tables, with the same tag compare
+        struct Stash
+        {
+            std::uint8_t tags[cuckoo::STASH_SIZE];                                    // fingerprint of each entry (EMPTY_TAG marks a free entry)
+            std::uint64_t hashCodes[cuckoo::STASH_SIZE];                              // hash code of each entry, to move it back without rehashing its key
+            alignas(HashNode) unsigned char storage[cuckoo::STASH_SIZE][sizeof(HashNode)]; // the records
+
+            HashNode &node(std::size_t slot)
+            { return *std::launder(reinterpret_cast<HashNode *>(storage[slot])); }
+            const HashNode &node(std::size_t slot) const
+            { return *std::launder(reinterpret_cast<const HashNode *>(storage[slot])); }
+        };
+
+        // the "whichTable" position() reports for a stashed record
+        static constexpr int STASH_TABLE = 2 * static_cast<int>(TableCount) + 1;
+
+        // TableCount as a "whichTable". Tables are numbered 1 to TABLES, and their previous generation
+        // TABLES + 1 to 2 * TABLES
+        static constexpr int TABLES = static_cast<int>(TableCount);
+
+        // one bucket visited by the displacement path search. Following parent links from a bucket
+        // back to one of the key's own buckets spells out the chain of records to move.
+        struct PathNode
+        {
+            std::size_t bucket; // bucket index within its table
+            std::size_t parent; // node whose record moves into this bucket (NO_PARENT for the key's own buckets)
+            std::size_t depth;  // number of moves from the key's own bucket to this one
+            int table;          // 1 to TABLES
+            int slot;           // slot of the parent bucket holding the record that moves here
+        };
+
+        static constexpr std::size_t NO_PARENT = static_cast<std::size_t>(-1);
+
+        // the default longest displacement path, and the default policy's load at which insert() grows the tables
+        static constexpr std::size_t DEFAULT_MAX_PATH_LENGTH = cuckoo::maxPathLength(SlotsPerBucket, TableCount);
+        static constexpr double MAX_LOAD_FACTOR = cuckoo::maxLoadFactor(SlotsPerBucket, TableCount);
+
         // private data members
-        int tableSize;               // table size (will use PRIME_LIST for rehash values)
-        struct HashNode* table1;     // the primary hash table 
-        struct HashNode* table2;     // the secondary "eviction" table 
-        struct HashNode* tempTable1; // tempTable for rehash() 
-        struct HashNode* tempTable2; // tempTable for rehash() 
-        int tableSizeCounter;        // keeps track of which index of PRIME_LIST is in use for rehash()
-        int nodeCount1;              // keeps track of the number of initialized nodes in table1
-        int nodeCount2;              // keeps track of the number of initialized nodes in table2
+        std::size_t tableSize;       // number of buckets per table (resized on rehash as the load policy says)
+        Table tables[TableCount];    // the hash tables: table 1 is the primary one, the others take evicted records
+        Table oldTables[TableCount]; // previous generation of the tables while an incremental resize drains it (else empty)
+        std::size_t oldTableSize;    // number of buckets per table of the previous generation
+        std::size_t oldNodeCount;    // records still waiting in the previous generation
+        std::size_t migrateCursor;   // next previous-generation bucket to migrate
+        bool incremental;            // true when growth migrates records a few buckets per operation
+        std::size_t nodeCounts[TableCount]; // keeps track of the number of initialized nodes in each table
+        std::size_t maxPathLength;   // most displacements a single insert may perform
+        cuckoo::LoadPolicy policy;   // the loads at which the tables grow and shrink, and the growth factor
+        Stash stash;                 // records without a displacement path
+        std::size_t stashCount;      // number of records in the stash
+        std::vector<PathNode> pathQueue; // the displacement path search's queue, kept to reuse its memory
+        std::size_t threadCount;     // threads build() and rehash() may use
+        Hasher hasher;               // hash function object, evaluated once per operation by hashOf()
+        KeyEqual keyEqual;           // key equality predicate
+        typename std::allocator_traits<Allocator>::template rebind_alloc<cuckoo::CacheLine> allocator; // allocates the tables, a cache line at a time
+        mutable cuckoo::Instruments<CUCKOO_STATS != 0> instruments; // counters for stats() (empty unless CUCKOO_STATS is 1)
+        std::unique_ptr<cuckoo::CuckooFilter<Key, cuckoo::TABLE_FILTER_BITS, Hasher>> filter; // fingerprints of every key after set_filter(true), else nullptr
+
+        // the lookup overloads taking another key type K exist only for a transparent Hasher and KeyEqual
+        template <typename K>
+        using Transparent = std::enable_if_t<cuckoo::is_transparent<Hasher>::value && cuckoo::is_transparent<KeyEqual>::value && !std::is_same<K, Key>::value>;
 
         // private methods
-        int hash1(const string &key);                                        // hash function for table1
-        int hash2(const string &key);                                        // hash function for table2
-        bool isFourDigit(const int value);                                   // predicate for veryifing a valid birth year 
-        void evictToOne(const string &key, const int value, int staticPass); // finds evicted records a new home in table 1 
-        void evictToTwo(const string &key, const int value, int staticPass); // finds evicted records a new home in table 2
-        bool rehash();                                                       // rehash method to increase the tableSize;
-        int position(const string &key, int &whichTable);                    // helper for delete(). Returns the index of a found record
-        void insert(const string &key, const int value, int signal);         // overloaded insert() called by rehash()
-        void evictToOne(const string &key, const int value);                 // overloaded evictToOne() for use by overloaded insert()
-        void evictToTwo(const string &key, const int value);                 // overloaded evictToTwo() for use by overloaded insert()
-
-    public: 
+        template <typename K>
+        std::uint64_t hashOf(const K &key) const;                                // the 64-bit hash code all positions derive from
+        template <typename K>
+        int findSlot(BucketRef bucket, const K &key, std::uint8_t tag) const;     // slot holding key within bucket, or -1
+        template <typename K, typename V>
+        bool insertRecord(K &&key, V &&value);                                   // shared body of insert() and emplace()
+        template <typename K, typename V>
+        cuckoo::Status storeRecord(K &&key, V &&value, std::uint64_t hashCode, bool assign); // adds a record (with assign, or replaces its value), without logging
+        template <typename K>
+        cuckoo::Status eraseRecord(const K &key, std::uint64_t hashCode);       // removes a record, without logging
+        std::size_t writeBatch(const Key *keys, const Value *values, std::size_t count, cuckoo::Status *out, bool assign); // shared body of insert_batch() and upsert_batch()
+        void reserveFor(std::size_t added);                                      // grows the tables at least growthFactor fold when added more records do not fit
+        template <typename K>
+        const Value *findValue(const K &key) const;                              // shared body of the search() overloads
+        template <typename K>
+        Value *findMutableValue(const K &key);                                   // shared body of the non-const search() overloads
+        template <typename K>
+        bool containsKey(const K &key) const;                                    // shared body of the contains() overloads
+        template <typename K>
+        void removeKey(const K &key);                                            // shared body of the remove() overloads
+        static int freeSlot(BucketRef bucket);                                   // first free slot within bucket, or -1
+        bool overLoaded() const;                                                 // true when insert() has to grow the tables
+        bool place(Key &key, Value &value, std::uint8_t tag, std::uint64_t hashCode); // seats a record known to be absent, false when tables and stash are full
+        bool placeInTables(Key &key, Value &value, std::uint8_t tag, std::uint64_t hashCode, std::size_t maxMoves); // seats a record in the tables, false when no path was found
+        std::size_t findPath(std::uint64_t hashCode, std::size_t maxMoves, int &slot); // breadth-first search for a free slot reachable by displacements
+        void refillFromStash(std::size_t maxMoves);                              // moves stashed records back into the tables where they fit
+        void unstash(std::size_t slot);                                          // destroys a stash entry and marks it free
+        bool onPath(std::size_t node, int table, std::size_t bucket) const;      // true when a bucket already lies on the path to node
+        std::size_t &countOf(int whichTable)                                     // the record count of a current table
+        { return nodeCounts[whichTable - 1]; }
+        std::size_t tableRecords() const;                                        // records in the current tables
+        bool grow();                                                             // starts a migration, or rehashes, to growthFactor times the size
+        std::size_t grownSize() const;                                           // the table size one growth step leads to
+        std::size_t sizeFor(std::size_t count, double load) const;               // smallest table size holding count records at the given load
+        void shrinkIfUnderLoaded();                                              // applies the policy's shrink threshold after a removal
+        void startMigration(std::size_t newTableSize);                           // makes new tables current and keeps the old ones for migrate()
+        void migrate(std::size_t bucketBudget);                                  // moves up to bucketBudget old buckets (per table) into the current tables
+        void gatherRecords(const Table &table, std::size_t size, std::vector<RecordRef> &records); // collects the records of a table for bulkPlace()
+        std::size_t partsFor(std::size_t count) const;                           // number of threads a bulk pass over count records uses
+        template <typename KeyOf, typename Construct>
+        std::vector<std::size_t> bulkPlace(std::size_t count, const std::uint64_t *hashCodes, KeyOf keyOf, Construct construct, bool unique); // places a batch into free slots of the records' own buckets
+        const Table &tableOf(int whichTable) const;                              // maps a position() "whichTable" to its table
+        static std::size_t tableLines(std::size_t size);                         // cache lines of memory a table of size buckets takes
+        Table allocateTable(std::size_t size);                                   // size empty buckets of zeroed memory
+        void allocateTables(Table (&newTables)[TableCount], std::size_t size);   // allocateTable() for every table, or (if an allocation throws) none
+        void freeTable(const Table &table, std::size_t size);                    // destroys the records of a table and frees it
+        static void clearSlot(BucketRef bucket, std::size_t slot);               // destroys a slot's record and marks it free
+        bool rehash(std::size_t newTableSize);                                   // rehash method to change the tableSize;
+        void keepAsOldGeneration(std::vector<HashNode> &records);                // holds records the tables cannot take in a previous generation of their own
+        template <typename K>
+        std::int64_t position(const K &key, std::uint64_t hashCode, int &whichTable, int &slot) const; // helper for delete(). Returns the bucket of a found record
+        void prefetchBuckets(std::uint64_t hashCode) const;                      // starts loading every bucket of a hash code
+        void countLookup(std::int64_t index, int whichTable) const;              // feeds a lookup's position() result to the instruments
+        bool filterExcludes(std::uint64_t hashCode) const                        // true when the filter rules the key out (never without a filter)
+        { return filter != nullptr && !filter->contains_hash(hashCode); }
+        void addToFilter(std::uint64_t hashCode);                                // records a new key in the filter, rebuilding a full one larger
+        void rebuildFilter(std::size_t capacity);                                // a new filter for capacity records, holding every key
+        std::size_t filterCapacity() const;                                      // the records a filter sized now should hold
+
+    public:
+
+        using key_type = Key;                              // the Key template parameter
+        using mapped_type = Value;                         // the Value template parameter
+        using allocator_type = Allocator;                  // the Allocator template parameter
 
         // ctors and dtor
-        CuckooHash();                                    // default constructor
-        CuckooHash(const string &key, const int value);  // constructor taking an initial key - value pair
-        ~CuckooHash();                                   // destructor 
+        CuckooHash();                                      // default constructor
+        explicit CuckooHash(const Allocator &allocator);   // constructor taking the allocator for the tables
+        CuckooHash(const Key &key, const Value &value);    // constructor taking an initial key - value pair
+        CuckooHash(const CuckooHash &) = delete;           // tables are owned, copying is not supported
+        CuckooHash &operator=(const CuckooHash &) = delete;
+        ~CuckooHash();                                     // destructor
 
         // public methods
-        void insert(const string &key, const int value); // insert into the hash table 
-        int search(const string &key);                   // search the hash table for a record
-        void remove(const string &key);                  // remove a record from the hash table 
-        bool contains(const string &key);                // find if the hash table contains a record    
-        int size() const                                 // getter for the number of total records (in table1 + in table2)
-        { return nodeCount1 + nodeCount2; }   
-        void display() const;                            // display the hash table  
-        int capacity() const                             // getter for the internal tableSize of the hash table. This detail would likely be abstracted away under normal circumstances 
+        void insert(const Key &key, const Value &value)    // insert into the hash table
+        { insertRecord(key, value); }
+        void insert(Key &&key, Value &&value)              // insert overload moving the key and value in
+        { insertRecord(std::move(key), std::move(value)); }
+        template <typename... Args>
+        bool emplace(Args &&...args);                      // insert a record constructed from args, false if it was not added
+        cuckoo::Status insert_or_assign(const Key &key, const Value &value) // insert a record, or replace the value of the key's record
+        { return storeRecord(key, value, hashOf(key), true); }
+        cuckoo::Status insert_or_assign(Key &&key, Value &&value) // insert_or_assign() moving the key and value in
+        {
+            std::uint64_t hashCode = hashOf(key);
+            return storeRecord(std::move(key), std::move(value), hashCode, true);
+        }
+        std::size_t insert_batch(const Key *keys, const Value *values, std::size_t count, cuckoo::Status *out = nullptr) // insert() for count records, returns the number added
+        { return writeBatch(keys, values, count, out, false); }
+        std::size_t upsert_batch(const Key *keys, const Value *values, std::size_t count, cuckoo::Status *out = nullptr) // insert_or_assign() for count records, returns the number added
+        { return writeBatch(keys, values, count, out, true); }
+        std::size_t remove_batch(const Key *keys, std::size_t count, cuckoo::Status *out = nullptr); // remove() for count keys, returns the number removed
+        const Value *search(const Key &key) const          // search the hash table for a record (nullptr if absent)
+        { return findValue(key); }
+        Value *search(const Key &key)                      // search overload granting write access to the value
+        { return findMutableValue(key); }
+        void remove(const Key &key)                        // remove a record from the hash table
+        { removeKey(key); }
+        bool contains(const Key &key) const                // find if the hash table contains a record
+        { return containsKey(key); }
+        template <typename K, typename = Transparent<K>>
+        const Value *search(const K &key) const            // search() by another key type, e.g. std::string_view for std::string keys
+        { return findValue(key); }
+        template <typename K, typename = Transparent<K>>
+        Value *search(const K &key)                        // non-const search() by another key type
+        { return findMutableValue(key); }
+        template <typename K, typename = Transparent<K>>
+        void remove(const K &key)                          // remove() by another key type
+        { removeKey(key); }
+        template <typename K, typename = Transparent<K>>
+        bool contains(const K &key) const                  // contains() by another key type
+        { return containsKey(key); }
+        std::size_t search_batch(const Key *keys, std::size_t count, const Value **out) const; // search() for count keys, returns the number found
+        std::size_t contains_batch(const Key *keys, std::size_t count, bool *out) const;       // contains() for count keys, returns the number found
+        std::size_t size() const                           // getter for the number of total records (in the tables, any previous generation and the stash)
+        { return tableRecords() + oldNodeCount + stashCount; }
+        void display() const;                              // display the hash table (requires operator<< for Key and Value)
+        template <typename Function>
+        void for_each(Function visit) const;               // call visit(key, value) for every record, in no particular order
+        std::size_t capacity() const                       // getter for the internal tableSize of the hash table. This detail would likely be abstracted away under normal circumstances
         { return tableSize; }
+        void reserve(std::size_t count);                   // pre-size the tables so that count records fit without a rehash
+        double load_factor() const                         // fraction of all slots (all tables) holding a record
+        { return static_cast<double>(size()) / (static_cast<double>(TableCount) * tableSize * SlotsPerBucket); }
+        void set_incremental_resize(bool enabled);         // choose between incremental and stop-the-world growth
+        void set_filter(bool enabled);                     // keep a cuckoo::CuckooFilter of the keys, which answers most lookups of absent keys
+        bool filtered() const                              // true after set_filter(true)
+        { return filter != nullptr; }
+        Allocator get_allocator() const                    // a copy of the allocator of the tables
+        { return Allocator(allocator); }
+        bool set_load_policy(const cuckoo::LoadPolicy &newPolicy); // set the grow and shrink thresholds, false (keeping the current policy) if invalid
+        const cuckoo::LoadPolicy &load_policy() const      // getter for the load policy
+        { return policy; }
+        void shrink_to_fit();                              // rehash into the smallest tables that hold the records below the maximum load
+        bool resizing() const                              // true while an incremental resize is migrating records
+        { return oldTables[0].memory != nullptr; }
+        template <typename RandomIt>
+        std::size_t build(RandomIt first, RandomIt last);  // bulk load a range of key - value pairs, returns the number added
+        template <typename RandomIt>
+        std::size_t build(RandomIt first, RandomIt last, const std::uint64_t *hashCodes); // build() with each key's hash_code() computed by the caller
+        template <typename K>
+        std::uint64_t hash_code(const K &key) const        // the hash code the table positions a key by, e.g. to hash keys on other threads for build()
+        { return hashOf(key); }
+        void set_thread_count(std::size_t threads)         // threads build() and rehash() may use for large batches (at least 1)
+        { threadCount = threads > 0 ? threads : 1; }
+        std::size_t thread_count() const                   // getter for the thread count
+        { return threadCount; }
+        void set_max_path_length(std::size_t length)       // most displacements one insert may perform before the tables grow instead
+        { maxPathLength = length; }
+        std::size_t max_path_length() const                // getter for the displacement bound
+        { return maxPathLength; }
+
+        // a snapshot of the table's occupancy, and of what its operations did
+        struct Stats
+        {
+            std::size_t records;       // size()
+            std::size_t buckets;       // capacity(), buckets per table
+            double loadFactor;         // load_factor()
+            double tableLoad[TableCount]; // fraction of each current table's slots holding a record
+            std::size_t stashed;       // records held in the stash. A stash that stays full means the tables need to grow
+            std::size_t stashCapacity; // STASH_SIZE
+            bool resizing;             // resizing()
+            std::size_t filterBytes;   // memory of the filter (0 without one)
+            bool instrumented;         // true when compiled with CUCKOO_STATS, and metrics holds counts
+            cuckoo::Metrics metrics;   // the operation counters (all zero unless instrumented)
+        };
+        Stats stats() const;                               // getter for the snapshot
 };
 
+/* Default Constructor
+*
+*  Initialize table size to INITIAL_TABLE_SIZE.
+*  When a rehash is necessary, the table size
+*  is multiplied by GROWTH_FACTOR (the default LoadPolicy).
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::CuckooHash()
+    : CuckooHash(Allocator())
+{
+}
+
+/* allocator Constructor
+*
+*  Initialize table size to INITIAL_TABLE_SIZE, with the tables' memory coming from allocator.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::CuckooHash(const Allocator &allocator)
+    : tableSize(cuckoo::INITIAL_TABLE_SIZE), oldTables(), oldTableSize(0), oldNodeCount(0),
+      migrateCursor(0), incremental(false), nodeCounts(), maxPathLength(DEFAULT_MAX_PATH_LENGTH),
+      policy{ MAX_LOAD_FACTOR, static_cast<double>(cuckoo::GROWTH_FACTOR), MAX_LOAD_FACTOR * cuckoo::SHRINK_LOAD_FRACTION }, stash(), stashCount(0),
+      threadCount(std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1), allocator(allocator)
+{
+    allocateTables(tables, tableSize);
+}
+
+/* key-value Constructor
+*
+*  Initialize table size to INITIAL_TABLE_SIZE.
+*  When a rehash is necessary, the table size
+*  is multiplied by GROWTH_FACTOR. Take in an intital key and value to pass to insert().
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::CuckooHash(const Key &key, const Value &value)
+    : CuckooHash()
+{
+    // call insert with given key and value
+    insert(key, value);
+}
+
+/* ~Destructor()
+*
+*  Destructs the hash tables used for the CuckooHash object (and a previous generation, if any).
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::~CuckooHash()
+{
+    for (std::size_t t = 0; t < TableCount; ++t)
+    {
+        freeTable(tables[t], tableSize);
+        freeTable(oldTables[t], oldTableSize);
+    }
+
+    for (std::size_t s = 0; s < cuckoo::STASH_SIZE; ++s)
+    {
+        if (stash.tags[s] != cuckoo::EMPTY_TAG)
+        {
+            unstash(s);
+        }
+    }
+}
+
+/* insertRecord()
+*
+*  body of insert() and emplace(): storeRecord() without replacing, which reports a key that already exists
+*  on std::cerr. Returns true if the record was added.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+template <typename K, typename V>
+bool CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::insertRecord(K &&key, V &&value)
+{
+    std::uint64_t hashCode = hashOf(key);
+    cuckoo::Status status = storeRecord(std::forward<K>(key), std::forward<V>(value), hashCode, false);
+    if (status == cuckoo::Status::Exists)
+    {
+        std::cerr << "key already exists within the hash table\n";
+    }
+
+    return status == cuckoo::Status::Inserted;
+}
+
+/* storeRecord()
+*
+*  the one write path of a record, given its key's hash code. If the given key is unique, the record is stored in a free slot of its table 1 bucket, or failing that,
+*  of its bucket in the next table. If the tables have reached their maximum load, they are first grown.
+*  If all its buckets are full, place() displaces records along the shortest path to a free slot. When no
+*  path of at most max_path_length() moves exists, the record is stashed, and when the stash is full too,
+*  the tables are grown and the record placed again. A key that exists keeps its record, unless assign
+*  is set, in which case its value is replaced. Nothing is logged: the returned status says what happened.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+template <typename K, typename V>
+cuckoo::Status CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::storeRecord(K &&key, V &&value, std::uint64_t hashCode, bool assign)
+{
+    // the instruments time the whole call, whichever way it returns
+    struct Timing
+    {
+        decltype(instruments) &counters;
+        decltype(instruments.now()) started;
+        ~Timing() { counters.insert(started); }
+    } timing{ instruments, instruments.now() };
+
+    // an incremental resize advances by a few buckets on every operation
+    if (resizing())
+    {
+        migrate(cuckoo::MIGRATE_BUCKETS);
+    }
+
+    // all positions and the fingerprint derive from the one hash code, for checking if this key is a duplicate
+    std::uint8_t tag = cuckoo::tagOf(hashCode);
+
+    // CONDITION ONE: key must be unique amongst all tables (of both generations)
+    // use the hash code to index into the tables and verify this key is unique (a key the filter rules out is)
+    int whichTable = -1;
+    int slot = -1;
+    std::int64_t index = filterExcludes(hashCode) ? -1 : position(key, hashCode, whichTable, slot);
+    if (index != -1)
+    {
+        if (assign)
+        {
+            Value &stored = whichTable == STASH_TABLE ? stash.node(slot).value : tableOf(whichTable)[index].value(slot);
+            stored = std::forward<V>(value);
+
+            return cuckoo::Status::Assigned;
+        }
+
+        instruments.duplicate();
+
+        return cuckoo::Status::Exists;
+    }
+
+    // CONDITION TWO: check that the tables are below their maximum load.
+    // if not, grow them
+    if (overLoaded())
+    {
+        if (grow() == 1)
+        {
+            return cuckoo::Status::Failed;
+        }
+    }
+
+    // the one copy (or move) of the record. Displacements and growth only ever move it
+    Key newKey(std::forward<K>(key));
+    Value newValue(std::forward<V>(value));
+    while (!place(newKey, newValue, tag, hashCode))
+    {
+        if (grow() == 1)
+        {
+            return cuckoo::Status::Failed;
+        }
+    }
+    addToFilter(hashCode);
+
+    return cuckoo::Status::Inserted;
+}
+
+/* writeBatch()
+*
+*  body of insert_batch() and upsert_batch(). Records are taken BATCH_GROUP at a time, as search_batch()
+*  takes keys: all of a group are hashed and their buckets prefetched before the first one is stored,
+*  and then each goes through storeRecord() in batch order (so of two equal keys in a batch, insert_batch()
+*  keeps the first and upsert_batch() the last value). insert_batch() first grows the tables for the
+*  whole batch, as build() does. Stores each record's status in out, unless out is nullptr, and returns
+*  the number of records added.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+std::size_t CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::writeBatch(const Key *keys, const Value *values, std::size_t count, cuckoo::Status *out, bool assign)
+{
+    if (!assign)
+    {
+        reserveFor(count);
+    }
+
+    std::uint64_t hashCodes[cuckoo::BATCH_GROUP];
+    std::size_t added = 0;
+
+    for (std::size_t start = 0; start < count; start += cuckoo::BATCH_GROUP)
+    {
+        std::size_t group = count - start < cuckoo::BATCH_GROUP ? count - start : cuckoo::BATCH_GROUP;
+
+        for (std::size_t i = 0; i < group; ++i)
+        {
+            hashCodes[i] = hashOf(keys[start + i]);
+            prefetchBuckets(hashCodes[i]);
+        }
+
+        for (std::size_t i = 0; i < group; ++i)
+        {
+            cuckoo::Status status = storeRecord(keys[start + i], values[start + i], hashCodes[i], assign);
+            added += status == cuckoo::Status::Inserted ? 1 : 0;
+            if (out != nullptr)
+            {
+                out[start + i] = status;
+            }
+        }
+    }
+
+    return added;
+}
+
+/* remove_batch()
+*
+*  removes the records of keys[0] to keys[count - 1], with the hashing and prefetching of search_batch()
+*  (keys the filter rules out are not prefetched). Stores cuckoo::Status::Removed or Missing for each key
+*  in out, unless out is nullptr, and returns the number of records removed. Nothing is logged.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+std::size_t CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::remove_batch(const Key *keys, std::size_t count, cuckoo::Status *out)
+{
+    std::uint64_t hashCodes[cuckoo::BATCH_GROUP];
+    std::size_t removed = 0;
+
+    for (std::size_t start = 0; start < count; start += cuckoo::BATCH_GROUP)
+    {
+        std::size_t group = count - start < cuckoo::BATCH_GROUP ? count - start : cuckoo::BATCH_GROUP;
+
+        for (std::size_t i = 0; i < group; ++i)
+        {
+            hashCodes[i] = hashOf(keys[start + i]);
+            if (!filterExcludes(hashCodes[i]))
+            {
+                prefetchBuckets(hashCodes[i]);
+            }
+        }
+
+        for (std::size_t i = 0; i < group; ++i)
+        {
+            cuckoo::Status status = eraseRecord(keys[start + i], hashCodes[i]);
+            removed += status == cuckoo::Status::Removed ? 1 : 0;
+            if (out != nullptr)
+            {
+                out[start + i] = status;
+            }
+        }
+    }
+
+    return removed;
+}
+
+/* emplace()
+*
+*  constructs a key - value pair from args (as std::pair<Key, Value> would) and inserts it. Returns
+*  true if the record was added, false if its key already exists.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+template <typename... Args>
+bool CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::emplace(Args &&...args)
+{
+    std::pair<Key, Value> record(std::forward<Args>(args)...);
+
+    return insertRecord(std::move(record.first), std::move(record.second));
+}
+
+/* place()
+*
+*  seats a record whose key is known to be absent in the tables, or failing that, in the stash.
+*  Returns false, leaving key and value untouched, when both are full.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+bool CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::place(Key &key, Value &value, std::uint8_t tag, std::uint64_t hashCode)
+{
+    if (placeInTables(key, value, tag, hashCode, maxPathLength))
+    {
+        return true;
+    }
+    instruments.pathFailure();
+
+    std::uint32_t free = cuckoo::matchTags<cuckoo::STASH_SIZE>(stash.tags, cuckoo::EMPTY_TAG);
+    if (free == 0)
+    {
+        return false;
+    }
+
+    int slot = cuckoo::lowestSlot(free);
+    new (stash.storage[slot]) HashNode{ std::move(key), std::move(value) };
+    stash.tags[slot] = tag;
+    stash.hashCodes[slot] = hashCode;
+    ++stashCount;
+
+    return true;
+}
+
+/* placeInTables()
+*
+*  seats a record in a free slot of its table 1 bucket, else of its
+*  bucket in a later table, else at the start of a displacement path of at most maxMoves moves found by findPath(). The records on the path
+*  are shifted one step each, beginning with the one next to the free slot, so every move lands in a
+*  slot that is already free. Returns false, leaving key and value untouched, when there is no path.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+bool CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::placeInTables(Key &key, Value &value, std::uint8_t tag, std::uint64_t hashCode, std::size_t maxMoves)
+{
+    int slot = -1;
+    std::size_t node = findPath(hashCode, maxMoves, slot);
+    if (node == NO_PARENT)
+    {
+        return false;
+    }
+    instruments.path(pathQueue[node].depth);
+
+    // walk the path back from its free slot, moving each record one bucket forward
+    while (pathQueue[node].parent != NO_PARENT)
+    {
+        const PathNode &to = pathQueue[node];
+        const PathNode &from = pathQueue[to.parent];
+        BucketRef source = tableOf(from.table)[from.bucket];
+        BucketRef target = tableOf(to.table)[to.bucket];
+
+        target.construct(slot, std::move(source.key(to.slot)), std::move(source.value(to.slot)));
+        target.tags[slot] = source.tags[to.slot];
+        clearSlot(source, to.slot);
+        --countOf(from.table);
+        ++countOf(to.table);
+
+        slot = to.slot;
+        node = to.parent;
+    }
+
+    BucketRef home = tableOf(pathQueue[node].table)[pathQueue[node].bucket];
+    home.construct(slot, std::move(key), std::move(value));
+    home.tags[slot] = tag;
+    ++countOf(pathQueue[node].table);
+
+    return true;
+}
+
+/* findPath()
+*
+*  breadth-first search from the key's buckets. A bucket with a free slot ends the search, and
+*  a full bucket queues the alternate buckets (one per other table) of each of its records, up to maxMoves moves deep and
+*  MAX_SEARCH_BUCKETS buckets in all. Buckets already on the path to a node are not queued again, so a
+*  path never moves one record twice. Returns the node of the bucket with the free slot (and the free
+*  slot in slot), or NO_PARENT. Nothing is moved.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+std::size_t CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::findPath(std::uint64_t hashCode, std::size_t maxMoves, int &slot)
+{
+    pathQueue.clear();
+    for (int t = 1; t <= TABLES; ++t)
+    {
+        pathQueue.push_back(PathNode{ cuckoo::hashAt(hashCode, t, tableSize), NO_PARENT, 0, t, -1 });
+    }
+
+    for (std::size_t head = 0; head < pathQueue.size(); ++head)
+    {
+        PathNode current = pathQueue[head];
+        BucketRef bucket = tableOf(current.table)[current.bucket];
+
+        slot = freeSlot(bucket);
+        if (slot != -1)
+        {
+            return head;
+        }
+
+        if (current.depth >= maxMoves)
+        {
+            continue;
+        }
+
+        // every record of a full bucket could move to its bucket in any other table
+        for (std::size_t s = 0; s < SlotsPerBucket && pathQueue.size() < cuckoo::MAX_SEARCH_BUCKETS; ++s)
+        {
+            std::uint64_t occupantHash = hashOf(bucket.key(s));
+            for (int otherTable = 1; otherTable <= TABLES && pathQueue.size() < cuckoo::MAX_SEARCH_BUCKETS; ++otherTable)
+            {
+                if (otherTable == current.table)
+                {
+                    continue;
+                }
+
+                std::size_t otherBucket = cuckoo::hashAt(occupantHash, otherTable, tableSize);
+                if (!onPath(head, otherTable, otherBucket))
+                {
+                    pathQueue.push_back(PathNode{ otherBucket, head, current.depth + 1, otherTable, static_cast<int>(s) });
+                }
+            }
+        }
+    }
+
+    return NO_PARENT;
+}
+
+/* onPath()
+*
+*  returns true if the bucket is node's own bucket or one of the buckets on the path leading to it
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+bool CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::onPath(std::size_t node, int table, std::size_t bucket) const
+{
+    for (; node != NO_PARENT; node = pathQueue[node].parent)
+    {
+        if (pathQueue[node].table == table && pathQueue[node].bucket == bucket)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* tableRecords()
+*
+*  the number of records in the current tables
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+std::size_t CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::tableRecords() const
+{
+    std::size_t records = 0;
+    for (std::size_t count : nodeCounts)
+    {
+        records += count;
+    }
+
+    return records;
+}
+
+/* refillFromStash()
+*
+*  tries to move every stashed record back into the tables, with displacement paths of at most maxMoves
+*  moves (0 only takes a free slot in one of the record's own buckets). Records that do not fit stay stashed.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+void CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::refillFromStash(std::size_t maxMoves)
+{
+    for (std::size_t s = 0; s < cuckoo::STASH_SIZE && stashCount > 0; ++s)
+    {
+        if (stash.tags[s] != cuckoo::EMPTY_TAG
+            && placeInTables(stash.node(s).key, stash.node(s).value, stash.tags[s], stash.hashCodes[s], maxMoves))
+        {
+            unstash(s);
+        }
+    }
+}
+
+/* unstash()
+*
+*  destroys the stash entry's record and marks the entry free
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+void CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::unstash(std::size_t slot)
+{
+    stash.node(slot).~HashNode();
+    stash.tags[slot] = cuckoo::EMPTY_TAG;
+    --stashCount;
+}
+
+/* findValue()
+*
+*  body of the const search() overloads. Looks first in table 1 to see if the key can be found in its hash bucket.
+*  If not present, looks instead in the following tables for the record (and, during an incremental resize,
+*  in the previous generation). If found, a pointer to the value is returned. If the record
+*  is not found at any hash location, nullptr is returned.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+template <typename K>
+const Value *CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::findValue(const K &key) const
+{
+    std::uint64_t hashCode = hashOf(key);
+    if (filterExcludes(hashCode))
+    {
+        instruments.filterReject();
+
+        return nullptr;
+    }
+
+    int whichTable = -1;
+    int slot = -1;
+    std::int64_t index = position(key, hashCode, whichTable, slot);
+    countLookup(index, whichTable);
+
+    if (index == -1)
+    {
+        // nullptr signals that the record could not be found
+        return nullptr;
+    }
+
+    if (whichTable == STASH_TABLE)
+    {
+        return &stash.node(slot).value;
+    }
+
+    return &tableOf(whichTable)[index].value(slot);
+}
+
+/* search_batch()
+*
+*  looks up keys[0] to keys[count - 1] and stores a pointer to each value (nullptr if absent) in out.
+*  Keys are taken BATCH_GROUP at a time: all of a group are hashed and all of their buckets prefetched
+*  before the first one is compared. Returns the number of keys found.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+std::size_t CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::search_batch(const Key *keys, std::size_t count, const Value **out) const
+{
+    std::uint64_t hashCodes[cuckoo::BATCH_GROUP];
+    bool excluded[cuckoo::BATCH_GROUP]; // keys the filter ruled out, whose buckets are neither prefetched nor probed
+    std::size_t found = 0;
+
+    for (std::size_t start = 0; start < count; start += cuckoo::BATCH_GROUP)
+    {
+        std::size_t group = count - start < cuckoo::BATCH_GROUP ? count - start : cuckoo::BATCH_GROUP;
+
+        for (std::size_t i = 0; i < group; ++i)
+        {
+            hashCodes[i] = hashOf(keys[start + i]);
+            excluded[i] = filterExcludes(hashCodes[i]);
+            if (!excluded[i])
+            {
+                prefetchBuckets(hashCodes[i]);
+            }
+        }
+
+        for (std::size_t i = 0; i < group; ++i)
+        {
+            if (excluded[i])
+            {
+                instruments.filterReject();
+                out[start + i] = nullptr;
+                continue;
+            }
+
+            int whichTable = -1;
+            int slot = -1;
+            std::int64_t index = position(keys[start + i], hashCodes[i], whichTable, slot);
+            countLookup(index, whichTable);
+
+            if (index == -1)
+            {
+                out[start + i] = nullptr;
+            }
+            else
+            {
+                out[start + i] = whichTable == STASH_TABLE ? &stash.node(slot).value : &tableOf(whichTable)[index].value(slot);
+                ++found;
+            }
+        }
+    }
+
+    return found;
+}
+
+/* contains_batch()
+*
+*  contains() for keys[0] to keys[count - 1], with the hashing and prefetching of search_batch().
+*  Stores each answer in out and returns the number of keys found.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+std::size_t CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::contains_batch(const Key *keys, std::size_t count, bool *out) const
+{
+    std::uint64_t hashCodes[cuckoo::BATCH_GROUP];
+    bool excluded[cuckoo::BATCH_GROUP]; // keys the filter ruled out, whose buckets are neither prefetched nor probed
+    std::size_t found = 0;
+
+    for (std::size_t start = 0; start < count; start += cuckoo::BATCH_GROUP)
+    {
+        std::size_t group = count - start < cuckoo::BATCH_GROUP ? count - start : cuckoo::BATCH_GROUP;
+
+        for (std::size_t i = 0; i < group; ++i)
+        {
+            hashCodes[i] = hashOf(keys[start + i]);
+            excluded[i] = filterExcludes(hashCodes[i]);
+            if (!excluded[i])
+            {
+                prefetchBuckets(hashCodes[i]);
+            }
+        }
+
+        for (std::size_t i = 0; i < group; ++i)
+        {
+            if (excluded[i])
+            {
+                instruments.filterReject();
+                out[start + i] = false;
+                continue;
+            }
+
+            int whichTable = -1;
+            int slot = -1;
+            std::int64_t index = position(keys[start + i], hashCodes[i], whichTable, slot);
+            countLookup(index, whichTable);
+            out[start + i] = index != -1;
+            found += out[start + i] ? 1 : 0;
+        }
+    }
+
+    return found;
+}
+
+/* countLookup()
+*
+*  counts a lookup from what position() returned. The probes follow from where the key was found: position()
+*  examines the tables in order, then any previous generation, then the stash (only while it holds records),
+*  so a key found in (previous-generation) table whichTable cost whichTable probes
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+void CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::countLookup(std::int64_t index, int whichTable) const
+{
+    if constexpr (CUCKOO_STATS != 0)
+    {
+        std::size_t tableProbes = static_cast<std::size_t>(TABLES) * (resizing() ? 2 : 1);
+        if (index == -1)
+        {
+            instruments.lookup(false, tableProbes + (stashCount > 0 ? 1 : 0), false);
+        }
+        else if (whichTable == STASH_TABLE)
+        {
+            instruments.lookup(true, tableProbes + 1, true);
+        }
+        else
+        {
+            instruments.lookup(true, static_cast<std::size_t>(whichTable), false);
+        }
+    }
+}
+
+/* stats()
+*
+*  the occupancy of the tables, and the instruments' counts
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+typename CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::Stats CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::stats() const
+{
+    Stats snapshot = Stats();
+    snapshot.records = size();
+    snapshot.buckets = tableSize;
+    snapshot.loadFactor = load_factor();
+    for (std::size_t t = 0; t < TableCount; ++t)
+    {
+        snapshot.tableLoad[t] = static_cast<double>(nodeCounts[t]) / (static_cast<double>(tableSize) * SlotsPerBucket);
+    }
+    snapshot.stashed = stashCount;
+    snapshot.stashCapacity = cuckoo::STASH_SIZE;
+    snapshot.resizing = resizing();
+    snapshot.filterBytes = filter != nullptr ? filter->memory_bytes() : 0;
+    snapshot.instrumented = CUCKOO_STATS != 0;
+    snapshot.metrics = instruments.snapshot();
+
+    return snapshot;
+}
+
+/* prefetchBuckets()
+*
+*  prefetches the first cache line of the bucket of a hash code in every table, which holds the
+*  tags and the first records (with cuckoo::Layout::SoA, only the tags). Fetching every line of larger
+*  buckets as well only crowds out the other keys of a batch.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+void CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::prefetchBuckets(std::uint64_t hashCode) const
+{
+    for (int t = 1; t <= TABLES; ++t)
+    {
+        cuckoo::prefetch(tables[t - 1][cuckoo::hashAt(hashCode, t, tableSize)].tags);
+    }
+}
+
+/* findMutableValue()
+*
+*  body of the non-const search() overloads, so callers may update a found value in place. Being non-const,
+*  it also advances an incremental resize.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+template <typename K>
+Value *CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::findMutableValue(const K &key)
+{
+    if (resizing())
+    {
+        migrate(cuckoo::MIGRATE_BUCKETS);
+    }
+
+    return const_cast<Value *>(findValue(key));
+}
+
+/* reserve()
+*
+*  grows the tables (never shrinks them) to the smallest size that holds count records below
+*  the maximum load, so that loading count records does not trigger a rehash part way through
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+void CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::reserve(std::size_t count)
+{
+    std::size_t neededSize = sizeFor(count, policy.maxLoadFactor);
+
+    if (neededSize > tableSize)
+    {
+        rehash(neededSize);
+    }
+}
+
+/* reserveFor()
+*
+*  makes room for added more records before a batch. A batch that outgrows the tables grows them at least
+*  growthFactor fold, so that a stream of batches (as cuckoo::load_file() sends) rehashes a logarithmic
+*  number of times instead of once per batch.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+void CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::reserveFor(std::size_t added)
+{
+    std::size_t fits = static_cast<std::size_t>(policy.maxLoadFactor * TableCount * SlotsPerBucket * tableSize);
+    if (size() + added > fits)
+    {
+        reserve(std::max(size() + added, static_cast<std::size_t>(fits * policy.growthFactor)));
+    }
+}
+
+/* set_incremental_resize()
+*
+*  with enabled, growth allocates the new tables and returns, and records migrate a few buckets
+*  per operation. Otherwise growth rehashes every record at once. Turning the mode off finishes
+*  a migration in progress.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+void CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::set_incremental_resize(bool enabled)
+{
+    incremental = enabled;
+
+    if (!incremental && resizing())
+    {
+        migrate(oldTableSize);
+    }
+}
+
+/* set_filter()
+*
+*  with enabled, builds a cuckoo::CuckooFilter of every key and keeps it up to date from then on:
+*  insert(), build() and remove() add and remove fingerprints, and a full filter is rebuilt larger.
+*  Lookups, and the uniqueness check of insert(), then consult the filter before the tables, so all
+*  but about 3% of the keys that are absent cost no table probe, while a key that is present costs the
+*  filter probe on top, so the filter pays off where most lookups miss. It takes one byte per slot,
+*  sized for the records the tables hold before they next grow. Disabling frees it.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+void CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::set_filter(bool enabled)
+{
+    if (!enabled)
+    {
+        filter.reset();
+    }
+    else if (filter == nullptr)
+    {
+        rebuildFilter(filterCapacity());
+    }
+}
+
+/* addToFilter()
+*
+*  adds the hash code of a record just placed to the filter, if there is one. A filter at its sized
+*  load, or one that finds no room for the fingerprint, is rebuilt for growthFactor times the records
+*  instead (which takes in the new record as well).
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+void CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::addToFilter(std::uint64_t hashCode)
+{
+    if (filter == nullptr)
+    {
+        return;
+    }
+
+    if (filter->size() + 1 > cuckoo::FILTER_MAX_LOAD * filter->capacity() || !filter->insert_hash(hashCode))
+    {
+        rebuildFilter(std::max(filterCapacity(), static_cast<std::size_t>(std::ceil(size() * policy.growthFactor))));
+    }
+}
+
+/* rebuildFilter()
+*
+*  replaces the filter with one sized for capacity records and adds the hash code of every record,
+*  in the tables, any previous generation and the stash. Keys whose fingerprints do not fit even
+*  then (many keys with one hash code) leave the table without a filter, as it would miss them.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+void CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::rebuildFilter(std::size_t capacity)
+{
+    filter.reset(new cuckoo::CuckooFilter<Key, cuckoo::TABLE_FILTER_BITS, Hasher>(capacity));
+    bool complete = true;
+
+    auto addTable = [&](const Table &table, std::size_t size)
+    {
+        for (std::size_t b = 0; b < size && complete; ++b)
+        {
+            BucketRef bucket = table[b];
+            for (std::size_t s = 0; s < SlotsPerBucket && complete; ++s)
+            {
+                if (bucket.tags[s] != cuckoo::EMPTY_TAG)
+                {
+                    complete = filter->insert_hash(hashOf(bucket.key(s)));
+                }
+            }
+        }
+    };
+
+    for (std::size_t t = 0; t < TableCount; ++t)
+    {
+        addTable(tables[t], tableSize);
+        if (resizing())
+        {
+            addTable(oldTables[t], oldTableSize);
+        }
+    }
+
+    for (std::size_t s = 0; s < cuckoo::STASH_SIZE && complete; ++s)
+    {
+        if (stash.tags[s] != cuckoo::EMPTY_TAG)
+        {
+            complete = filter->insert_hash(stash.hashCodes[s]);
+        }
+    }
+
+    if (!complete)
+    {
+        std::cerr << "the keys do not fit a filter, the table continues without one\n";
+        filter.reset();
+    }
+}
+
+/* filterCapacity()
+*
+*  the records the tables hold before they next grow (or, should the load exceed the maximum, all of them)
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+std::size_t CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::filterCapacity() const
+{
+    std::size_t fits = static_cast<std::size_t>(policy.maxLoadFactor * TableCount * SlotsPerBucket * tableSize);
+
+    return std::max(fits, size());
+}
+
+/* hashOf
+*
+*  the one hash computation of an operation (of a Key, or of another key type a transparent Hasher takes). The Hasher's result is used as is when the Hasher
+*  declares itself avalanching (cuckoo::Hash does), and is otherwise finalized with cuckoo::mixInt()
+*  so that both 32-bit halves are usable positions.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+template <typename K>
+std::uint64_t CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::hashOf(const K &key) const
+{
+    if constexpr (cuckoo::is_avalanching<Hasher>::value)
+    {
+        return static_cast<std::uint64_t>(hasher(key));
+    }
+    else
+    {
+        return cuckoo::mixInt(static_cast<std::uint64_t>(hasher(key)), cuckoo::DEFAULT_SEED);
+    }
+}
+
+/* findSlot()
+*
+*  compares the fingerprint against every tag of the bucket in one step, and only compares
+*  the full key of slots whose tag matched. Returns the slot holding key, or -1.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+template <typename K>
+int CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::findSlot(BucketRef bucket, const K &key, std::uint8_t tag) const
+{
+    for (std::uint32_t hits = cuckoo::matchTags<SlotsPerBucket>(bucket.tags, tag); hits != 0; hits &= hits - 1)
+    {
+        int slot = cuckoo::lowestSlot(hits);
+        if (keyEqual(bucket.key(slot), key))
+        {
+            return slot;
+        }
+    }
+
+    return -1;
+}
+
+/* freeSlot()
+*
+*  returns the first slot of the bucket without a record, or -1 when the bucket is full
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+int CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::freeSlot(BucketRef bucket)
+{
+    std::uint32_t empty = cuckoo::matchTags<SlotsPerBucket>(bucket.tags, cuckoo::EMPTY_TAG);
+
+    return empty == 0 ? -1 : cuckoo::lowestSlot(empty);
+}
+
+/* overLoaded()
+*
+*  the tables grow once the records fill the policy's maxLoadFactor of all slots (all tables together,
+*  so that reserve() can size for a record count without knowing how records split between tables)
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+bool CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::overLoaded() const
+{
+    return load_factor() >= policy.maxLoadFactor;
+}
+
+/* grow()
+*
+*  grows the tables by the policy's growthFactor: by starting a migration in incremental mode, or with a full
+*  rehash() otherwise. A growth needed while a migration is still running falls back to rehash(),
+*  which takes in the remaining previous-generation records as well.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+bool CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::grow()
+{
+    if (incremental && !resizing() && grownSize() <= cuckoo::MAX_TABLE_SIZE)
+    {
+        startMigration(grownSize());
+        instruments.migration();
+
+        return 0;
+    }
+
+    return rehash(grownSize());
+}
+
+/* grownSize()
+*
+*  the table size after one growth: growthFactor times the current size, and at least one bucket more
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+std::size_t CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::grownSize() const
+{
+    std::size_t grown = static_cast<std::size_t>(std::ceil(static_cast<double>(tableSize) * policy.growthFactor));
+
+    return grown > tableSize ? grown : tableSize + 1;
+}
+
+/* sizeFor()
+*
+*  the smallest table size (never below INITIAL_TABLE_SIZE) at which count records fill at most the given
+*  load of all slots
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+std::size_t CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::sizeFor(std::size_t count, double load) const
+{
+    std::size_t slotsPerPosition = TableCount * SlotsPerBucket; // one bucket in each table
+    std::size_t neededSize = static_cast<std::size_t>(std::ceil(count / (load * slotsPerPosition))) + 1;
+
+    return neededSize > cuckoo::INITIAL_TABLE_SIZE ? neededSize : cuckoo::INITIAL_TABLE_SIZE;
+}
+
+/* set_load_policy()
+*
+*  replaces the load policy, which takes effect from the next insert() or remove(). A policy whose shrink
+*  threshold is not below maxLoadFactor / growthFactor could shrink the tables straight back into growing,
+*  so it is refused like any other invalid one, with a message, keeping the current policy.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+bool CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::set_load_policy(const cuckoo::LoadPolicy &newPolicy)
+{
+    if (!(newPolicy.maxLoadFactor > 0 && newPolicy.maxLoadFactor <= 1 && newPolicy.growthFactor > 1
+          && newPolicy.shrinkLoadFactor >= 0 && newPolicy.shrinkLoadFactor < newPolicy.maxLoadFactor / newPolicy.growthFactor))
+    {
+        std::cerr << "invalid load policy: needs 0 < maxLoadFactor <= 1, growthFactor > 1 and 0 <= shrinkLoadFactor < maxLoadFactor / growthFactor\n";
+
+        return false;
+    }
+
+    policy = newPolicy;
+
+    return true;
+}
+
+/* shrink_to_fit()
+*
+*  rehashes the records into the smallest tables that hold them below the maximum load. Does nothing
+*  when the tables are that small already.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+void CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::shrink_to_fit()
+{
+    std::size_t fittedSize = sizeFor(size(), policy.maxLoadFactor);
+    if (fittedSize < tableSize)
+    {
+        rehash(fittedSize);
+    }
+
+    if (filter != nullptr)
+    {
+        rebuildFilter(filterCapacity());
+    }
+}
+
+/* shrinkIfUnderLoaded()
+*
+*  after a removal, rehashes tables whose load fell below the policy's shrinkLoadFactor into tables the
+*  records fill to half the maximum load, which leaves room to grow back before the next resize. An
+*  incremental resize in progress is left to finish first.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+void CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::shrinkIfUnderLoaded()
+{
+    if (policy.shrinkLoadFactor <= 0 || tableSize <= cuckoo::INITIAL_TABLE_SIZE || resizing() || load_factor() >= policy.shrinkLoadFactor)
+    {
+        return;
+    }
+
+    std::size_t shrunkSize = sizeFor(size(), policy.maxLoadFactor / 2);
+    if (shrunkSize < tableSize)
+    {
+        rehash(shrunkSize);
+
+        if (filter != nullptr)
+        {
+            rebuildFilter(filterCapacity());
+        }
+    }
+}
+
+/* startMigration()
+*
+*  the current tables become the previous generation, and new empty tables of newTableSize buckets
+*  become current. No record moves here, so the cost is one allocation.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+void CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::startMigration(std::size_t newTableSize)
+{
+    Table newTables[TableCount];
+    allocateTables(newTables, newTableSize);
+
+    oldTableSize = tableSize;
+    oldNodeCount = tableRecords();
+    migrateCursor = 0;
+
+    for (std::size_t t = 0; t < TableCount; ++t)
+    {
+        oldTables[t] = tables[t];
+        tables[t] = newTables[t];
+        nodeCounts[t] = 0;
+    }
+    tableSize = newTableSize;
+}
+
+/* migrate()
+*
+*  moves the records of up to bucketBudget previous-generation buckets of each table into the current
+*  tables, and frees the previous generation once its last bucket is done. A record is placed straight
+*  from its old slot, which it leaves only once it has a new one. When the tables and stash are full, the
+*  tables grow, and a rehash() (which drains the previous generation, this record included) ends the pass.
+*  If they cannot grow, the record stays where it is, and the next pass starts from its bucket again.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+void CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::migrate(std::size_t bucketBudget)
+{
+    for (; bucketBudget > 0 && resizing() && migrateCursor < oldTableSize; --bucketBudget)
+    {
+        std::size_t index = migrateCursor++;
+        for (const Table &table : oldTables)
+        {
+            BucketRef bucket = table[index];
+            for (std::size_t s = 0; s < SlotsPerBucket; ++s)
+            {
+                if (bucket.tags[s] == cuckoo::EMPTY_TAG)
+                {
+                    continue;
+                }
+
+                if (place(bucket.key(s), bucket.value(s), bucket.tags[s], hashOf(bucket.key(s))))
+                {
+                    clearSlot(bucket, s);
+                    --oldNodeCount;
+                    continue;
+                }
+
+                // the bucket is left unfinished, and the growth may replace the previous generation, so the pass ends here
+                migrateCursor = index;
+                grow();
+
+                return;
+            }
+        }
+    }
+
+    // the previous generation is empty once every bucket was visited
+    if (resizing() && migrateCursor >= oldTableSize)
+    {
+        for (Table &table : oldTables)
+        {
+            freeTable(table, oldTableSize);
+            table = Table();
+        }
+        oldTableSize = 0;
+        oldNodeCount = 0;
+    }
+}
+
+/* rehash()
+*
+*  allocates new tables of newTableSize buckets each (growthFactor times the size when growing, less when shrinking),
+*  and rehashes all records in the old tables (and any previous generation still being migrated)
+*  to the new tables using the new table size. Sizes are only bounded by MAX_TABLE_SIZE, past which
+*  the records stay where they are. Records that find no place even in tables grown to MAX_TABLE_SIZE
+*  are kept in a previous generation (see keepAsOldGeneration()), and 1 is returned.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+bool CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::rehash(std::size_t newTableSize)
+{
+    if (newTableSize > cuckoo::MAX_TABLE_SIZE)
+    {
+        std::cerr << "The hash table cannot grow past " << cuckoo::MAX_TABLE_SIZE << " buckets per table.\n";
+
+        // return 1 to signal insert() to return without attempting to insert
+        return 1;
+    }
+
+    auto started = instruments.now();
+
+    // allocate the new tables before touching any record
+    Table newTables[TableCount];
+    allocateTables(newTables, newTableSize);
+
+    // keep the old tables aside, and make the new ones current. Reset nodeCounts to allow the rehash
+    // loop to recompute these values (as the distribution of records is very likely to change)
+    Table previousTables[TableCount];
+    std::size_t previousTableSize = tableSize;
+    for (std::size_t t = 0; t < TableCount; ++t)
+    {
+        previousTables[t] = tables[t];
+        tables[t] = newTables[t];
+        nodeCounts[t] = 0;
+    }
+    tableSize = newTableSize;
+
+    // rehash all intialized nodes of the old tables (and of a migration in progress, which the same pass
+    // finishes) to the new tables. Further, see that the records are "renormalized", in that the first
+    // table will be the prime objective for hash slots.
+    std::vector<RecordRef> records;
+    for (const Table &table : previousTables)
+    {
+        gatherRecords(table, previousTableSize, records);
+    }
+    if (resizing())
+    {
+        for (const Table &table : oldTables)
+        {
+            gatherRecords(table, oldTableSize, records);
+        }
+    }
+
+    // hash every record once, in parallel for large tables
+    std::vector<std::uint64_t> hashCodes(records.size());
+    std::size_t parts = partsFor(records.size());
+    cuckoo::runParallel(parts, [&](std::size_t part)
+    {
+        for (std::size_t i = part * records.size() / parts; i < (part + 1) * records.size() / parts; ++i)
+        {
+            hashCodes[i] = hashOf(*records[i].key);
+        }
+    });
+
+    // most records move straight into a free slot of one of their own buckets, the rest go through place()
+    std::vector<std::size_t> leftover = bulkPlace(records.size(), hashCodes.data(),
+        [&](std::size_t i) -> const Key & { return *records[i].key; },
+        [&](std::size_t i, BucketRef bucket, int slot) { bucket.construct(slot, std::move(*records[i].key), std::move(*records[i].value)); },
+        false);
+
+    std::vector<HashNode> unplaced;
+    for (std::size_t i : leftover)
+    {
+        if (!place(*records[i].key, *records[i].value, cuckoo::tagOf(hashCodes[i]), hashCodes[i]))
+        {
+            unplaced.push_back(HashNode{ std::move(*records[i].key), std::move(*records[i].value) });
+        }
+    }
+
+    // delete the old arrays (freeTable() destroys the moved-from records)
+    for (const Table &table : previousTables)
+    {
+        freeTable(table, previousTableSize);
+    }
+
+    if (resizing())
+    {
+        for (Table &table : oldTables)
+        {
+            freeTable(table, oldTableSize);
+            table = Table();
+        }
+        oldTableSize = 0;
+        oldNodeCount = 0;
+    }
+
+    // the larger tables have room for what was stashed
+    refillFromStash(maxPathLength);
+
+    // this pass is done. A further pass for records it could not place counts on its own
+    instruments.rehash(started);
+
+    // a record without a displacement path (and no stash entry) even in the new tables needs still larger ones
+    while (!unplaced.empty())
+    {
+        if (rehash(grownSize()) == 1)
+        {
+            keepAsOldGeneration(unplaced);
+
+            return 1;
+        }
+
+        std::vector<HashNode> pending;
+        pending.swap(unplaced);
+        for (HashNode &node : pending)
+        {
+            std::uint64_t hashCode = hashOf(node.key);
+            if (!place(node.key, node.value, cuckoo::tagOf(hashCode), hashCode))
+            {
+                unplaced.push_back(std::move(node));
+            }
+        }
+    }
+
+    // 0 for good reallocation
+    return 0;
+}
+
+/* keepAsOldGeneration()
+*
+*  when the tables cannot grow to take every record, the ones left over (with those of a previous
+*  generation already kept) become a previous generation of their own, in tables just large enough that
+*  each record has a free slot in one of its buckets. Lookups find them there, and migrate() retries
+*  them on every operation, so no record is lost. The tables start at records.size() buckets and double
+*  until the records fit, which is planned before any record moves.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+void CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::keepAsOldGeneration(std::vector<HashNode> &records)
+{
+    if (resizing())
+    {
+        for (Table &table : oldTables)
+        {
+            for (std::size_t i = 0; i < oldTableSize; ++i)
+            {
+                BucketRef bucket = table[i];
+                for (std::size_t s = 0; s < SlotsPerBucket; ++s)
+                {
+                    if (bucket.tags[s] != cuckoo::EMPTY_TAG)
+                    {
+                        records.push_back(HashNode{ std::move(bucket.key(s)), std::move(bucket.value(s)) });
+                    }
+                }
+            }
+            freeTable(table, oldTableSize);
+            table = Table();
+        }
+    }
+
+    std::vector<std::uint64_t> hashCodes(records.size());
+    for (std::size_t i = 0; i < records.size(); ++i)
+    {
+        hashCodes[i] = hashOf(records[i].key);
+    }
+
+    for (std::size_t size = std::max(records.size(), cuckoo::INITIAL_TABLE_SIZE);; size *= 2)
+    {
+        // the bucket of each record, while counting the slots taken in every bucket
+        std::vector<std::size_t> taken(TableCount * size, 0);
+        std::vector<std::pair<int, std::size_t>> home(records.size());
+        bool fits = true;
+        for (std::size_t i = 0; i < records.size() && fits; ++i)
+        {
+            fits = false;
+            for (int t = 1; t <= TABLES && !fits; ++t)
+            {
+                std::size_t index = cuckoo::hashAt(hashCodes[i], t, size);
+                if (taken[(t - 1) * size + index] < SlotsPerBucket)
+                {
+                    home[i] = std::make_pair(t, index);
+                    ++taken[(t - 1) * size + index];
+                    fits = true;
+                }
+            }
+        }
+        if (!fits)
+        {
+            continue;
+        }
+
+        allocateTables(oldTables, size);
+        for (std::size_t i = 0; i < records.size(); ++i)
+        {
+            BucketRef bucket = oldTables[home[i].first - 1][home[i].second];
+            int slot = freeSlot(bucket);
+            bucket.construct(slot, std::move(records[i].key), std::move(records[i].value));
+            bucket.tags[slot] = cuckoo::tagOf(hashCodes[i]);
+        }
+        oldTableSize = size;
+        oldNodeCount = records.size();
+        migrateCursor = 0;
+        records.clear();
+
+        return;
+    }
+}
+
+/* gatherRecords()
+*
+*  helper for rehash(). Appends a pointer to every record of table to records.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+void CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::gatherRecords(const Table &table, std::size_t size, std::vector<RecordRef> &records)
+{
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        BucketRef bucket = table[i];
+        for (std::size_t s = 0; s < SlotsPerBucket; ++s)
+        {
+            if (bucket.tags[s] != cuckoo::EMPTY_TAG)
+            {
+                records.push_back(RecordRef{ &bucket.key(s), &bucket.value(s) });
+            }
+        }
+    }
+}
+
+/* partsFor()
+*
+*  a bulk pass over count records is split across threadCount threads once it is large enough to pay
+*  for starting them, and is never split finer than the tables' buckets
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+std::size_t CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::partsFor(std::size_t count) const
+{
+    if (count < cuckoo::PARALLEL_MIN_RECORDS)
+    {
+        return 1;
+    }
+
+    return threadCount < tableSize ? threadCount : tableSize;
+}
+
+/* bulkPlace()
+*
+*  seats records 0 to count - 1 of a batch, whose hash codes are given, in one pass per table. The first pass
+*  gives each thread its own range of table 1 buckets, and every thread places the records whose table 1 bucket
+*  lies in its range there, if the bucket has a free slot. Each following pass does the same with the next table
+*  for the records that did not fit yet. As no two threads ever write the same bucket, no locking is needed.
+*  keyOf(i) returns record i's key, and construct(i, bucket, slot) constructs record i in a free slot of bucket.
+*  With unique, records whose key is already stored (or came earlier in the batch) are skipped. Returns,
+*  in batch order, the records for which all buckets were full.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+template <typename KeyOf, typename Construct>
+std::vector<std::size_t> CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::bulkPlace(std::size_t count, const std::uint64_t *hashCodes, KeyOf keyOf, Construct construct, bool unique)
+{
+    std::size_t parts = partsFor(count);
+    std::vector<std::vector<std::vector<std::size_t>>> missed(TableCount, std::vector<std::vector<std::size_t>>(parts)); // per table and range, records whose buckets up to that table were all full
+    std::vector<std::vector<std::size_t>> placed(TableCount, std::vector<std::size_t>(parts, 0));                   // per table and range, records placed
+
+    // a record whose key is stored already. During a pass, the key's buckets in the other tables are only read,
+    // and its bucket in this table belongs to the calling thread, so the check needs no lock either
+    auto duplicate = [&](std::size_t i)
+    {
+        int whichTable = -1;
+        int slot = -1;
+        return unique && position(keyOf(i), hashCodes[i], whichTable, slot) != -1;
+    };
+
+    // one pass over the records of candidates (all of them when candidates is nullptr) for one table
+    auto pass = [&](int whichTable, const std::vector<std::vector<std::size_t>> *candidates,
+                    std::vector<std::vector<std::size_t>> &missedHere, std::vector<std::size_t> &placedHere)
+    {
+        const Table &table = tableOf(whichTable);
+        cuckoo::runParallel(parts, [&](std::size_t part)
+        {
+            std::size_t low = part * tableSize / parts;
+            std::size_t high = (part + 1) * tableSize / parts;
+
+            auto visit = [&](std::size_t i)
+            {
+                std::size_t index = cuckoo::hashAt(hashCodes[i], whichTable, tableSize);
+                if (index < low || index >= high || duplicate(i))
+                {
+                    return;
+                }
+
+                BucketRef bucket = table[index];
+                int slot = freeSlot(bucket);
+                if (slot == -1)
+                {
+                    missedHere[part].push_back(i);
+                    return;
+                }
+
+                construct(i, bucket, slot);
+                bucket.tags[slot] = cuckoo::tagOf(hashCodes[i]);
+                ++placedHere[part];
+            };
+
+            if (candidates == nullptr)
+            {
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    visit(i);
+                }
+            }
+            else
+            {
+                for (const std::vector<std::size_t> &list : *candidates)
+                {
+                    for (std::size_t i : list)
+                    {
+                        visit(i);
+                    }
+                }
+            }
+        });
+    };
+
+    for (int t = 1; t <= TABLES; ++t)
+    {
+        pass(t, t == 1 ? nullptr : &missed[t - 2], missed[t - 1], placed[t - 1]);
+    }
+
+    std::vector<std::size_t> leftover;
+    for (std::size_t part = 0; part < parts; ++part)
+    {
+        for (std::size_t t = 0; t < TableCount; ++t)
+        {
+            nodeCounts[t] += placed[t][part];
+        }
+        leftover.insert(leftover.end(), missed[TableCount - 1][part].begin(), missed[TableCount - 1][part].end());
+    }
+
+    // batch order, so that of two equal keys the first one stays
+    std::sort(leftover.begin(), leftover.end());
+
+    return leftover;
+}
+
+/* build()
+*
+*  bulk loads the key - value pairs (anything with .first and .second, such as std::pair) of the random
+*  access range [first, last). The tables are reserve()d for the whole batch, the keys are hashed in parallel,
+*  and bulkPlace() seats the records; the rest go through place() one at a time. A key already in the table,
+*  or repeated in the batch, keeps its first value. Returns the number of records added.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+template <typename RandomIt>
+std::size_t CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::build(RandomIt first, RandomIt last)
+{
+    static_assert(std::is_base_of<std::random_access_iterator_tag, typename std::iterator_traits<RandomIt>::iterator_category>::value,
+                  "build() needs a random access range");
+
+    std::size_t count = static_cast<std::size_t>(last - first);
+    std::vector<std::uint64_t> hashCodes(count);
+    std::size_t parts = partsFor(count);
+    cuckoo::runParallel(parts, [&](std::size_t part)
+    {
+        for (std::size_t i = part * count / parts; i < (part + 1) * count / parts; ++i)
+        {
+            hashCodes[i] = hashOf(first[i].first);
+        }
+    });
+
+    return build(first, last, hashCodes.data());
+}
+
+/* build()
+*
+*  overload for a batch whose keys were hashed beforehand: hashCodes[i] must be hash_code(first[i].first).
+*  A loader that hashes keys on its parsing threads calls this one, so the inserting thread only places records.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+template <typename RandomIt>
+std::size_t CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::build(RandomIt first, RandomIt last, const std::uint64_t *hashCodes)
+{
+    static_assert(std::is_base_of<std::random_access_iterator_tag, typename std::iterator_traits<RandomIt>::iterator_category>::value,
+                  "build() needs a random access range");
+
+    std::size_t count = static_cast<std::size_t>(last - first);
+    std::size_t before = size();
+
+    reserveFor(count);
+
+    // with a filter, the records bulkPlace() seats are marked (each by the one thread that seats it), and
+    // enter the filter after the passes, which only read it
+    std::vector<unsigned char> seated(filter != nullptr ? count : 0);
+    std::vector<std::size_t> leftover = bulkPlace(count, hashCodes,
+        [&](std::size_t i) -> const Key & { return first[i].first; },
+        [&](std::size_t i, BucketRef bucket, int slot)
+        {
+            bucket.construct(slot, first[i].first, first[i].second);
+            if (!seated.empty())
+            {
+                seated[i] = 1;
+            }
+        },
+        true);
+
+    // a filter too small for the whole batch is rebuilt once, for the grown tables (which takes in the seated records)
+    std::size_t seatedCount = static_cast<std::size_t>(std::count(seated.begin(), seated.end(), 1));
+    if (filter != nullptr && filter->size() + seatedCount > cuckoo::FILTER_MAX_LOAD * filter->capacity())
+    {
+        rebuildFilter(filterCapacity());
+    }
+    else
+    {
+        for (std::size_t i = 0; i < seated.size(); ++i)
+        {
+            if (seated[i] != 0)
+            {
+                addToFilter(hashCodes[i]);
+            }
+        }
+    }
+
+    for (std::size_t i : leftover)
+    {
+        int whichTable = -1;
+        int slot = -1;
+        if (position(first[i].first, hashCodes[i], whichTable, slot) != -1)
+        {
+            continue;
+        }
+
+        Key key = first[i].first;
+        Value value = first[i].second;
+        while (!place(key, value, cuckoo::tagOf(hashCodes[i]), hashCodes[i]))
+        {
+            if (grow() == 1)
+            {
+                return size() - before;
+            }
+        }
+        addToFilter(hashCodes[i]);
+    }
+
+    return size() - before;
+}
+
+/* containsKey()
+*
+*  body of the contains() overloads. Returns true if the key is found in the table, and false otherwise
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+template <typename K>
+bool CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::containsKey(const K &key) const
+{
+    std::uint64_t hashCode = hashOf(key);
+    if (filterExcludes(hashCode))
+    {
+        instruments.filterReject();
+
+        return false;
+    }
+
+    int whichTable = -1;
+    int slot = -1;
+    std::int64_t index = position(key, hashCode, whichTable, slot);
+    countLookup(index, whichTable);
+
+    return index != -1;
+}
+
+/* removeKey()
+*
+*  body of the remove() overloads: eraseRecord(), which reports a key that does not exist on std::cerr
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+template <typename K>
+void CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::removeKey(const K &key)
+{
+    if (eraseRecord(key, hashOf(key)) == cuckoo::Status::Missing)
+    {
+        std::cerr << "key does not exist within the table\n";
+    }
+}
+
+/* eraseRecord()
+*
+*  deletes the record of the key with the given hash code if it exists in any table, and otherwise does nothing. This version
+*  of a cuckoo delete does not promote a record from table 2 to table 1 when a record is deleted from table 1.
+*  Nothing is logged: returns cuckoo::Status::Removed or Missing.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+template <typename K>
+cuckoo::Status CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::eraseRecord(const K &key, std::uint64_t hashCode)
+{
+    if (resizing())
+    {
+        migrate(cuckoo::MIGRATE_BUCKETS);
+    }
+
+    int whichTable = -1;
+    int slot = -1;
+    std::int64_t index = filterExcludes(hashCode) ? -1 : position(key, hashCode, whichTable, slot);
+
+    // only a key that was found leaves the filter, as an absent key's fingerprint may be another key's
+    if (index != -1 && filter != nullptr)
+    {
+        filter->remove_hash(hashCode);
+    }
+
+    // a stashed record only frees its stash entry
+    if (index != -1 && whichTable == STASH_TABLE)
+    {
+        unstash(slot);
+
+        return cuckoo::Status::Removed;
+    }
+
+    // if the key is in the table
+    if (index != -1)
+    {
+        // release the record and mark this slot as free
+        clearSlot(tableOf(whichTable)[index], slot);
+
+        // decrement the count of the table the record was in
+        if (whichTable <= TABLES)
+        {
+            --countOf(whichTable);
+        }
+        else
+        {
+            --oldNodeCount;
+        }
+
+        // the freed slot may be the one a stashed record was missing
+        if (stashCount > 0)
+        {
+            refillFromStash(0);
+        }
+
+        shrinkIfUnderLoaded();
+
+        return cuckoo::Status::Removed;
+    }
+    else
+    {
+        return cuckoo::Status::Missing;
+    }
+}
+
+/* position()
+*
+*  helper for insert(), delete(), search() and contains(). Returns the bucket index of the record,
+*  if it is found, and -1 otherwise. Also updates the reference parameters "whichTable" (1 to TABLES, TABLES + 1
+*  to 2 * TABLES for the previous generation of a table, or STASH_TABLE), and "slot" to the slot within the bucket
+*  (or stash), which tell the caller where the record lives.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+template <typename K>
+std::int64_t CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::position(const K &key, std::uint64_t hashCode, int &whichTable, int &slot) const
+{
+    std::uint8_t tag = cuckoo::tagOf(hashCode);
+
+    // the key's bucket in each table, in table order. TABLES is a constant, so the loop unrolls
+    for (int t = 1; t <= TABLES; ++t)
+    {
+        std::size_t index = cuckoo::hashAt(hashCode, t, tableSize);
+
+        // if a key in that bucket matches the key argument, return the index
+        slot = findSlot(tables[t - 1][index], key, tag);
+        if (slot != -1)
+        {
+            whichTable = t;
+            return static_cast<std::int64_t>(index);
+        }
+    }
+
+    // during an incremental resize, the record may not have migrated yet
+    if (resizing())
+    {
+        for (int t = 1; t <= TABLES; ++t)
+        {
+            std::size_t index = cuckoo::hashAt(hashCode, t, oldTableSize);
+            slot = findSlot(oldTables[t - 1][index], key, tag);
+            if (slot != -1)
+            {
+                whichTable = TABLES + t; // for the previous generation of table t
+                return static_cast<std::int64_t>(index);
+            }
+        }
+    }
+
+    // the stash is only searched while it holds records
+    if (stashCount > 0)
+    {
+        for (std::uint32_t hits = cuckoo::matchTags<cuckoo::STASH_SIZE>(stash.tags, tag); hits != 0; hits &= hits - 1)
+        {
+            slot = cuckoo::lowestSlot(hits);
+            if (keyEqual(stash.node(slot).key, key))
+            {
+                whichTable = STASH_TABLE;
+                return 0;
+            }
+        }
+    }
+
+    // return -1 to signal that there is no such record
+    return -1;
+}
+
+/* tableOf()
+*
+*  maps the "whichTable" reported by position() to the table it stands for
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+const typename CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::Table &CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::tableOf(int whichTable) const
+{
+    return whichTable <= TABLES ? tables[whichTable - 1] : oldTables[whichTable - TABLES - 1];
+}
+
+/* tableLines()
+*
+*  the cache lines a table of size buckets occupies: its buckets, or with cuckoo::Layout::SoA its three
+*  arrays, each starting on a cache line
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+std::size_t CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::tableLines(std::size_t size)
+{
+    auto lines = [](std::size_t bytes) { return (bytes + cuckoo::CACHE_LINE - 1) / cuckoo::CACHE_LINE; };
+
+    if constexpr (SlotLayout == cuckoo::Layout::SoA)
+    {
+        return lines(size * SlotsPerBucket) + lines(size * SlotsPerBucket * sizeof(Key)) + lines(size * SlotsPerBucket * sizeof(Value));
+    }
+    else
+    {
+        return lines(size * sizeof(Bucket));
+    }
+}
+
+/* allocateTable()
+*
+*  allocates a table of size empty buckets from the allocator. All-zero memory is an empty table, so
+*  with a zeroing allocator (such as the default) no per-slot work is done here, and growing to a large
+*  size does not stall on initializing the new tables. Memory from any other allocator is cleared first.
+*  The arrays of cuckoo::Layout::SoA each start on a cache line.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+typename CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::Table CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::allocateTable(std::size_t size)
+{
+    static_assert(alignof(Bucket) <= cuckoo::CACHE_LINE, "buckets must fit the cache line alignment of their table");
+
+    Table table = Table();
+
+    std::size_t lineCount = tableLines(size);
+    cuckoo::CacheLine *lines = std::allocator_traits<decltype(allocator)>::allocate(allocator, lineCount);
+    if constexpr (!cuckoo::is_zeroing<decltype(allocator)>::value)
+    {
+        std::memset(static_cast<void *>(lines), 0, lineCount * sizeof(cuckoo::CacheLine));
+    }
+    table.memory = reinterpret_cast<unsigned char *>(lines);
+
+    if constexpr (SlotLayout == cuckoo::Layout::SoA)
+    {
+        static_assert(alignof(Key) <= cuckoo::CACHE_LINE && alignof(Value) <= cuckoo::CACHE_LINE, "keys and values must fit the cache line alignment of their arrays");
+
+        auto lineBytes = [](std::size_t bytes) { return (bytes + cuckoo::CACHE_LINE - 1) / cuckoo::CACHE_LINE * cuckoo::CACHE_LINE; };
+        table.keys = table.memory + lineBytes(size * SlotsPerBucket);
+        table.values = table.keys + lineBytes(size * SlotsPerBucket * sizeof(Key));
+    }
+    else
+    {
+        static_assert(std::is_trivially_default_constructible<Bucket>::value, "an all-zero Bucket must be an empty Bucket");
+    }
+
+    return table;
+}
+
+/* allocateTables()
+*
+*  allocates every table of size buckets into newTables. When an allocation throws (std::bad_alloc, or a
+*  NumaAllocator that cannot place the memory), the tables already allocated are freed before the
+*  exception leaves, and newTables holds no memory.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+void CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::allocateTables(Table (&newTables)[TableCount], std::size_t size)
+{
+    std::size_t allocated = 0;
+    try
+    {
+        for (; allocated < TableCount; ++allocated)
+        {
+            newTables[allocated] = allocateTable(size);
+        }
+    }
+    catch (...)
+    {
+        for (std::size_t t = 0; t < allocated; ++t)
+        {
+            freeTable(newTables[t], size);
+            newTables[t] = Table();
+        }
+        throw;
+    }
+}
+
+/* freeTable()
+*
+*  destroys every record still stored in the table (nothing to do for trivially destructible records)
+*  and frees the table's memory. An empty Table() is ignored.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+void CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::freeTable(const Table &table, std::size_t size)
+{
+    if (table.memory == nullptr)
+    {
+        return;
+    }
+
+    if (!std::is_trivially_destructible<HashNode>::value)
+    {
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            BucketRef bucket = table[i];
+            for (std::size_t s = 0; s < SlotsPerBucket; ++s)
+            {
+                if (bucket.tags[s] != cuckoo::EMPTY_TAG)
+                {
+                    bucket.key(s).~Key();
+                    bucket.value(s).~Value();
+                }
+            }
+        }
+    }
+
+    std::allocator_traits<decltype(allocator)>::deallocate(allocator, reinterpret_cast<cuckoo::CacheLine *>(table.memory), tableLines(size));
+}
+
+/* clearSlot()
+*
+*  destroys the record in the slot and marks the slot free
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+void CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::clearSlot(BucketRef bucket, std::size_t slot)
+{
+    bucket.key(slot).~Key();
+    bucket.value(slot).~Value();
+    bucket.tags[slot] = cuckoo::EMPTY_TAG;
+}
+
+/* display()
+*
+*  prints every record of the tables (of both generations during an incremental resize) and of the stash as "key : value"
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+void CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::display() const
+{
+    for_each([](const Key &key, const Value &value)
+    {
+        std::cout << key << " : " << value << "\n";
+    });
+    // output a new line
+    std::cout << "\n";
+}
+
+/* for_each()
+*
+*  calls visit(key, value) for every record: those of the tables in bucket order (of both generations during
+*  an incremental resize), then those of the stash. visit must not modify the table.
+*/
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+template <typename Function>
+void CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator>::for_each(Function visit) const
+{
+    for (int t = 1; t <= 2 * TABLES; ++t)
+    {
+        std::size_t size = t <= TABLES ? tableSize : oldTableSize;
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            BucketRef bucket = tableOf(t)[i];
+            for (std::size_t s = 0; s < SlotsPerBucket; ++s)
+            {
+                if (bucket.tags[s] != cuckoo::EMPTY_TAG)
+                {
+                    visit(static_cast<const Key &>(bucket.key(s)), static_cast<const Value &>(bucket.value(s)));
+                }
+            }
+        }
+    }
+    for (std::size_t s = 0; s < cuckoo::STASH_SIZE; ++s)
+    {
+        if (stash.tags[s] != cuckoo::EMPTY_TAG)
+        {
+            visit(stash.node(s).key, stash.node(s).value);
+        }
+    }
+}
+
 #endif // CUCKOOHASH_HPP_INCLUDED
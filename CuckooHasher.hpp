@@ -0,0 +1,264 @@
+/*
+    Data Structures
+    Project Hash: Cuckoo Hashing
+    Author: Anthony Lupica <arl127@uakron.edu> 2022
+
+    Header file for the hashing layer used by the CuckooHash class template.
+
+    cuckoo::Hash<Key> is the default Hasher. It produces one well-mixed 64-bit hash code
+    per key: strings are hashed with a wyhash-style multiply-fold over 8 or 16 byte words,
+    and integers with a single 128-bit multiply-fold, so both are a handful of instructions
+    for short keys. CuckooHash computes this code once per operation and derives both table
+    positions from its two 32-bit halves.
+
+    Any other Hasher may be plugged in. Unless it declares an "is_avalanching" member type
+    (promising that every output bit depends on every input bit, as cuckoo::Hash does),
+    CuckooHash runs its result through cuckoo::mixInt() first, so weak hashes such as the
+    identity std::hash<int> still spread over both halves.
+
+    The string hashers (and cuckoo::Equal<std::string>, the default key equality for string keys)
+    are transparent: they accept std::string_view and C strings as they are, so a CuckooHash with
+    std::string keys can be searched by either without building a std::string first.
+*/
+
+#ifndef CUCKOOHASHER_HPP_INCLUDED
+#define CUCKOOHASHER_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace cuckoo
+{
+    // seed used by default constructed hashers
+    constexpr std::uint64_t DEFAULT_SEED = 0x2d358dccaa6c78a5ULL;
+
+    // mixing constants of the wyhash family
+    constexpr std::uint64_t SECRET[4] = { 0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL, 0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL };
+
+    /* mul128()
+    *
+    *  full 64 x 64 -> 128 bit multiply, returned as its low and high halves
+    */
+    constexpr void mul128(std::uint64_t a, std::uint64_t b, std::uint64_t &low, std::uint64_t &high)
+    {
+#if defined(__SIZEOF_INT128__)
+        unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+        low = static_cast<std::uint64_t>(product);
+        high = static_cast<std::uint64_t>(product >> 64);
+#else
+        std::uint64_t aHigh = a >> 32, aLow = a & 0xFFFFFFFFULL;
+        std::uint64_t bHigh = b >> 32, bLow = b & 0xFFFFFFFFULL;
+        std::uint64_t lowLow = aLow * bLow, lowHigh = aLow * bHigh, highLow = aHigh * bLow, highHigh = aHigh * bHigh;
+        std::uint64_t middle = (lowLow >> 32) + (lowHigh & 0xFFFFFFFFULL) + (highLow & 0xFFFFFFFFULL);
+        low = (middle << 32) | (lowLow & 0xFFFFFFFFULL);
+        high = highHigh + (lowHigh >> 32) + (highLow >> 32) + (middle >> 32);
+#endif
+    }
+
+    /* wymix()
+    *
+    *  multiplies a and b to 128 bits and folds the halves together with xor
+    */
+    constexpr std::uint64_t wymix(std::uint64_t a, std::uint64_t b)
+    {
+        std::uint64_t low = 0, high = 0;
+        mul128(a, b, low, high);
+
+        return low ^ high;
+    }
+
+    /* mixInt()
+    *
+    *  hash of a single 64-bit word (integers, pointers, or the output of a non-avalanching Hasher)
+    */
+    constexpr std::uint64_t mixInt(std::uint64_t value, std::uint64_t seed)
+    {
+        return wymix(value ^ seed ^ SECRET[0], SECRET[1] ^ seed);
+    }
+
+    /* read64() / read32()
+    *
+    *  little-endian loads written as byte shifts, so they stay usable in constant expressions.
+    *  Optimizing compilers turn them into a single unaligned load.
+    */
+    constexpr std::uint64_t read64(const char *p)
+    {
+        return static_cast<std::uint64_t>(static_cast<unsigned char>(p[0]))
+            | static_cast<std::uint64_t>(static_cast<unsigned char>(p[1])) << 8
+            | static_cast<std::uint64_t>(static_cast<unsigned char>(p[2])) << 16
+            | static_cast<std::uint64_t>(static_cast<unsigned char>(p[3])) << 24
+            | static_cast<std::uint64_t>(static_cast<unsigned char>(p[4])) << 32
+            | static_cast<std::uint64_t>(static_cast<unsigned char>(p[5])) << 40
+            | static_cast<std::uint64_t>(static_cast<unsigned char>(p[6])) << 48
+            | static_cast<std::uint64_t>(static_cast<unsigned char>(p[7])) << 56;
+    }
+
+    constexpr std::uint64_t read32(const char *p)
+    {
+        return static_cast<std::uint64_t>(static_cast<unsigned char>(p[0]))
+            | static_cast<std::uint64_t>(static_cast<unsigned char>(p[1])) << 8
+            | static_cast<std::uint64_t>(static_cast<unsigned char>(p[2])) << 16
+            | static_cast<std::uint64_t>(static_cast<unsigned char>(p[3])) << 24;
+    }
+
+    /* hashBytes()
+    *
+    *  wyhash-style hash of len bytes. Keys up to 16 bytes are read with at most four overlapping
+    *  loads, longer keys are consumed 16 bytes (and above 48 bytes, three independent 16 byte lanes)
+    *  per multiply-fold.
+    */
+    constexpr std::uint64_t hashBytes(const char *p, std::size_t len, std::uint64_t seed)
+    {
+        seed ^= wymix(seed ^ SECRET[0], SECRET[1]);
+
+        std::uint64_t a = 0, b = 0;
+        if (len <= 16)
+        {
+            if (len >= 4)
+            {
+                std::size_t shift = (len >> 3) << 2;
+                a = (read32(p) << 32) | read32(p + shift);
+                b = (read32(p + len - 4) << 32) | read32(p + len - 4 - shift);
+            }
+            else if (len > 0)
+            {
+                a = static_cast<std::uint64_t>(static_cast<unsigned char>(p[0])) << 16
+                    | static_cast<std::uint64_t>(static_cast<unsigned char>(p[len >> 1])) << 8
+                    | static_cast<std::uint64_t>(static_cast<unsigned char>(p[len - 1]));
+            }
+        }
+        else
+        {
+            std::size_t remaining = len;
+            if (remaining > 48)
+            {
+                std::uint64_t lane1 = seed, lane2 = seed;
+                do
+                {
+                    seed = wymix(read64(p) ^ SECRET[1], read64(p + 8) ^ seed);
+                    lane1 = wymix(read64(p + 16) ^ SECRET[2], read64(p + 24) ^ lane1);
+                    lane2 = wymix(read64(p + 32) ^ SECRET[3], read64(p + 40) ^ lane2);
+                    p += 48;
+                    remaining -= 48;
+                } while (remaining > 48);
+                seed ^= lane1 ^ lane2;
+            }
+            while (remaining > 16)
+            {
+                seed = wymix(read64(p) ^ SECRET[1], read64(p + 8) ^ seed);
+                p += 16;
+                remaining -= 16;
+            }
+            a = read64(p + remaining - 16);
+            b = read64(p + remaining - 8);
+        }
+
+        mul128(a ^ SECRET[1], b ^ seed, a, b);
+
+        return wymix(a ^ SECRET[0] ^ len, b ^ SECRET[1]);
+    }
+
+    /* fastRange()
+    *
+    *  maps a 32-bit hash onto [0, n) with one multiply and a shift instead of a division
+    *  (Lemire's "fastrange"). Any n works, and for a power of two n it selects the hash's top bits.
+    */
+    constexpr std::uint32_t fastRange(std::uint32_t hash, std::uint32_t n)
+    {
+        return static_cast<std::uint32_t>((static_cast<std::uint64_t>(hash) * n) >> 32);
+    }
+
+    /* Hash
+    *
+    *  default Hasher for CuckooHash. The generic version finalizes std::hash, and is specialized
+    *  below for integers / enums and for strings.
+    */
+    template <typename Key, typename Enable = void>
+    struct Hash
+    {
+        using is_avalanching = void;
+
+        std::uint64_t seed;
+
+        constexpr explicit Hash(std::uint64_t seed = DEFAULT_SEED) : seed(seed) {}
+
+        std::uint64_t operator()(const Key &key) const
+        { return mixInt(static_cast<std::uint64_t>(std::hash<Key>{}(key)), seed); }
+    };
+
+    template <typename Key>
+    struct Hash<Key, typename std::enable_if<std::is_integral<Key>::value || std::is_enum<Key>::value>::type>
+    {
+        using is_avalanching = void;
+
+        std::uint64_t seed;
+
+        constexpr explicit Hash(std::uint64_t seed = DEFAULT_SEED) : seed(seed) {}
+
+        constexpr std::uint64_t operator()(Key key) const
+        { return mixInt(static_cast<std::uint64_t>(key), seed); }
+    };
+
+    struct StringHash
+    {
+        using is_avalanching = void;
+        using is_transparent = void;
+
+        std::uint64_t seed;
+
+        constexpr explicit StringHash(std::uint64_t seed = DEFAULT_SEED) : seed(seed) {}
+
+        constexpr std::uint64_t operator()(std::string_view key) const
+        { return hashBytes(key.data(), key.size(), seed); }
+    };
+
+    template <>
+    struct Hash<std::string> : StringHash
+    {
+        using StringHash::StringHash;
+    };
+
+    template <>
+    struct Hash<std::string_view> : StringHash
+    {
+        using StringHash::StringHash;
+    };
+
+    /* Equal
+    *
+    *  default KeyEqual for CuckooHash: std::equal_to<Key>, except for strings, which compare
+    *  transparently against std::string_view and C strings
+    */
+    template <typename Key>
+    struct Equal : std::equal_to<Key> {};
+
+    template <>
+    struct Equal<std::string> : std::equal_to<> {};
+
+    template <>
+    struct Equal<std::string_view> : std::equal_to<> {};
+
+    template <typename Hasher, typename = void>
+    struct is_avalanching : std::false_type {};
+
+    template <typename Hasher>
+    struct is_avalanching<Hasher, std::void_t<typename Hasher::is_avalanching>> : std::true_type {};
+
+    template <typename Hasher, typename = void>
+    struct has_seed : std::false_type {};
+
+    template <typename Hasher>
+    struct has_seed<Hasher, std::void_t<decltype(Hasher(std::uint64_t()).seed)>> : std::true_type {};
+
+    template <typename T, typename = void>
+    struct is_transparent : std::false_type {};
+
+    template <typename T>
+    struct is_transparent<T, std::void_t<typename T::is_transparent>> : std::true_type {};
+}
+
+#endif // CUCKOOHASHER_HPP_INCLUDED
@@ -0,0 +1,377 @@
+/*
+    Data Structures
+    Project Hash: Cuckoo Hashing
+    Author: Anthony Lupica <arl127@uakron.edu> 2022
+
+    Header file for cuckoo::load_file(), a streaming loader that fills a CuckooHash from a
+    file of key - value records, one per line (by default "name,year").
+
+    Ex.] Birth Years From Disk
+    CuckooHash<std::string, int> birthYears;
+    cuckoo::LoadStats loaded = cuckoo::load_file("birthYears.csv", birthYears);
+    std::cout << loaded.records << " records, " << loaded.rejected << " malformed lines";
+
+    Inserting one record at a time from one thread caps a load far below what a disk delivers.
+    load_file() instead runs the file through a bounded pipeline of three stages:
+
+        read   one thread reads the file in chunks of LOAD_CHUNK_BYTES, cut at the last line break
+               (the partial line is carried over to the next chunk), into recycled buffers
+        parse  worker threads slice each chunk into lines and fields as std::string_views of the
+               read buffer, build the chunk's records and compute their hash_code()s
+        insert the calling thread hands each parsed chunk to CuckooHash::build() with those hash
+               codes, so it only places records, in file order
+
+    Nothing is copied between the read buffer and the table: a key's bytes are copied once, when the
+    record's Key is constructed from its slice. At most LOAD_CHUNKS_PER_WORKER chunks per worker are
+    between being read and being inserted, which bounds the loader's memory however large the file.
+
+    As with build(), a key repeated in the file keeps its first value. Lines the parser rejects (such
+    as a header line) are counted in LoadStats::rejected, and blank lines are skipped.
+
+    The parser is a template parameter: any callable bool(std::string_view line, std::string_view &key,
+    Value &value) may replace cuckoo::CsvParse, e.g. for another separator or a non-numeric value.
+*/
+
+#ifndef CUCKOOLOADER_HPP_INCLUDED
+#define CUCKOOLOADER_HPP_INCLUDED
+
+#include <algorithm>
+#include <charconv>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "CuckooHash.hpp"
+
+namespace cuckoo
+{
+    // bytes read from the file per chunk. Large enough that build() splits a chunk's records across threads
+    const std::size_t LOAD_CHUNK_BYTES = 1 << 22;
+
+    // chunks per parsing thread that may be read but not yet inserted, which bounds the loader's memory
+    const std::size_t LOAD_CHUNKS_PER_WORKER = 2;
+
+    /* trimSpaces()
+    *
+    *  the view without its leading and trailing spaces, tabs and carriage returns
+    */
+    inline std::string_view trimSpaces(std::string_view text)
+    {
+        const char *SPACES = " \t\r";
+        std::size_t first = text.find_first_not_of(SPACES);
+        if (first == std::string_view::npos)
+        {
+            return std::string_view();
+        }
+
+        return text.substr(first, text.find_last_not_of(SPACES) - first + 1);
+    }
+
+    /* CsvParse
+    *
+    *  default parser of load_file(): the key is everything before the line's last comma (so names may
+    *  contain commas), the value everything after it, read with std::from_chars. Surrounding spaces are
+    *  ignored. Rejects a line without a comma, with an empty key, or whose value does not parse in full.
+    */
+    struct CsvParse
+    {
+        template <typename Value>
+        bool operator()(std::string_view line, std::string_view &key, Value &value) const
+        {
+            std::size_t comma = line.rfind(',');
+            if (comma == std::string_view::npos)
+            {
+                return false;
+            }
+
+            key = trimSpaces(line.substr(0, comma));
+            std::string_view field = trimSpaces(line.substr(comma + 1));
+            std::from_chars_result result = std::from_chars(field.data(), field.data() + field.size(), value);
+
+            return !key.empty() && !field.empty() && result.ec == std::errc() && result.ptr == field.data() + field.size();
+        }
+    };
+
+    // what load_file() did
+    struct LoadStats
+    {
+        std::size_t bytes;    // bytes read from the file
+        std::size_t lines;    // non-blank lines
+        std::size_t records;  // records added to the table (a repeated or already present key adds none)
+        std::size_t rejected; // lines the parser rejected
+    };
+
+    /* load_file()
+    *
+    *  streams the file at path into table through the read - parse - insert pipeline described above,
+    *  with workers parsing threads (by default all hardware threads but two, at least one). Returns what
+    *  was loaded. A file that cannot be opened, or fails mid-read, is reported on std::cerr, and the
+    *  records read before the failure stay in the table. An exception thrown in any stage (by parse, by a
+    *  Key constructor, or std::bad_alloc from the table) stops all of them, and is rethrown once every
+    *  thread has been joined, again keeping the records inserted before it.
+    */
+    template <typename Table, typename Parse = CsvParse>
+    LoadStats load_file(const std::string &path, Table &table, Parse parse = Parse(), std::size_t workers = 0)
+    {
+        using Key = typename Table::key_type;
+        using Value = typename Table::mapped_type;
+
+        // a run of whole lines, as read
+        struct Chunk
+        {
+            std::size_t sequence;    // position of the chunk within the file
+            std::vector<char> bytes; // the read buffer, which may extend past length
+            std::size_t length;      // bytes of whole lines at the start of the buffer
+        };
+
+        // the records of one chunk, ready for build()
+        struct Batch
+        {
+            std::vector<std::pair<Key, Value>> records;
+            std::vector<std::uint64_t> hashCodes; // table.hash_code() of every record's key
+            std::size_t lines;
+            std::size_t rejected;
+        };
+
+        LoadStats stats = LoadStats();
+
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+        {
+            std::cerr << "could not open " << path << " for loading\n";
+
+            return stats;
+        }
+
+        if (workers == 0)
+        {
+            std::size_t hardware = std::thread::hardware_concurrency();
+            workers = hardware > 2 ? hardware - 2 : 1;
+        }
+        const std::size_t MAX_IN_FLIGHT = workers * LOAD_CHUNKS_PER_WORKER;
+
+        // state shared by the stages, all guarded by one mutex (each stage holds it only to hand a chunk on)
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::deque<Chunk> readChunks;                // read, waiting for a parsing thread
+        std::map<std::size_t, Batch> parsedBatches;  // parsed, waiting for their turn to be inserted
+        std::vector<std::vector<char>> freeBuffers;  // parsed chunks' buffers, for the reader to reuse
+        std::size_t inFlight = 0;                    // chunks read but not yet inserted
+        std::size_t chunkCount = 0;                  // chunks read so far
+        bool readDone = false;                       // set once the reader has queued its last chunk
+        bool aborted = false;                        // set once a stage has thrown, which stops every stage
+        std::exception_ptr failure;                  // the first exception a stage threw
+        std::size_t bytesRead = 0;                   // the reader's own count, read after it is joined
+
+        // records the exception being handled (unless one is recorded already) and wakes every stage to stop
+        auto stopAll = [&]()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!failure)
+            {
+                failure = std::current_exception();
+            }
+            aborted = true;
+            changed.notify_all();
+        };
+
+        std::thread reader([&]()
+        {
+            try
+            {
+                std::vector<char> carry; // the partial last line of the previous read
+                bool end = false;
+                while (!end)
+                {
+                    std::vector<char> buffer;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        changed.wait(lock, [&]() { return aborted || inFlight < MAX_IN_FLIGHT; });
+                        if (aborted)
+                        {
+                            return;
+                        }
+                        if (!freeBuffers.empty())
+                        {
+                            buffer.swap(freeBuffers.back());
+                            freeBuffers.pop_back();
+                        }
+                    }
+
+                    buffer.resize(carry.size() + LOAD_CHUNK_BYTES);
+                    std::copy(carry.begin(), carry.end(), buffer.begin());
+                    file.read(buffer.data() + carry.size(), static_cast<std::streamsize>(LOAD_CHUNK_BYTES));
+                    std::size_t filled = carry.size() + static_cast<std::size_t>(file.gcount());
+                    bytesRead += static_cast<std::size_t>(file.gcount());
+
+                    if (file.bad())
+                    {
+                        std::cerr << "reading " << path << " failed, the rest of the file is not loaded\n";
+                        filled = carry.size();
+                    }
+                    end = !file;
+
+                    // cut after the last line break, unless the file ends here (a line longer than the whole
+                    // buffer leaves no break, and is carried over in full)
+                    std::size_t length = filled;
+                    if (!end)
+                    {
+                        const char *last = buffer.data() + filled;
+                        while (last != buffer.data() && last[-1] != '\n')
+                        {
+                            --last;
+                        }
+                        length = static_cast<std::size_t>(last - buffer.data());
+                    }
+                    carry.assign(buffer.begin() + static_cast<std::ptrdiff_t>(length), buffer.begin() + static_cast<std::ptrdiff_t>(filled));
+
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (length > 0)
+                    {
+                        readChunks.push_back(Chunk{ chunkCount++, std::move(buffer), length });
+                        ++inFlight;
+                    }
+                    else
+                    {
+                        freeBuffers.push_back(std::move(buffer));
+                    }
+                    readDone = end;
+                    changed.notify_all();
+                }
+            }
+            catch (...)
+            {
+                stopAll();
+            }
+        });
+
+        // the parsing threads' loop: parse read chunks until the reader is done and none are left
+        auto parseChunks = [&]()
+        {
+            try
+            {
+                for (;;)
+                {
+                    Chunk chunk;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        changed.wait(lock, [&]() { return aborted || !readChunks.empty() || readDone; });
+                        if (aborted || readChunks.empty())
+                        {
+                            return;
+                        }
+                        chunk = std::move(readChunks.front());
+                        readChunks.pop_front();
+                    }
+
+                    Batch batch = Batch();
+                    const char *next = chunk.bytes.data();
+                    const char *end = next + chunk.length;
+                    while (next != end)
+                    {
+                        const char *lineEnd = static_cast<const char *>(std::memchr(next, '\n', static_cast<std::size_t>(end - next)));
+                        if (lineEnd == nullptr)
+                        {
+                            lineEnd = end;
+                        }
+                        std::string_view line(next, static_cast<std::size_t>(lineEnd - next));
+                        next = lineEnd == end ? end : lineEnd + 1;
+
+                        if (trimSpaces(line).empty())
+                        {
+                            continue;
+                        }
+                        ++batch.lines;
+
+                        std::string_view key;
+                        Value value = Value();
+                        if (!parse(line, key, value))
+                        {
+                            ++batch.rejected;
+                            continue;
+                        }
+                        batch.records.emplace_back(Key(key), std::move(value));
+                        batch.hashCodes.push_back(table.hash_code(batch.records.back().first));
+                    }
+
+                    std::lock_guard<std::mutex> lock(mutex);
+                    freeBuffers.push_back(std::move(chunk.bytes));
+                    parsedBatches.emplace(chunk.sequence, std::move(batch));
+                    changed.notify_all();
+                }
+            }
+            catch (...)
+            {
+                stopAll();
+            }
+        };
+
+        std::vector<std::thread> parsers;
+        try
+        {
+            for (std::size_t w = 0; w < workers; ++w)
+            {
+                parsers.emplace_back(parseChunks);
+            }
+
+            // insert on the calling thread, one chunk at a time in file order
+            for (std::size_t sequence = 0;; ++sequence)
+            {
+                Batch batch;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    changed.wait(lock, [&]() { return aborted || parsedBatches.count(sequence) != 0 || (readDone && sequence == chunkCount); });
+                    if (aborted || parsedBatches.count(sequence) == 0)
+                    {
+                        break;
+                    }
+                    batch = std::move(parsedBatches[sequence]);
+                    parsedBatches.erase(sequence);
+                }
+
+                stats.records += table.build(batch.records.begin(), batch.records.end(), batch.hashCodes.data());
+                stats.lines += batch.lines;
+                stats.rejected += batch.rejected;
+
+                std::lock_guard<std::mutex> lock(mutex);
+                --inFlight;
+                changed.notify_all();
+            }
+        }
+        catch (...)
+        {
+            stopAll();
+        }
+
+        // every thread is joined before a failure is rethrown, as destroying a joinable std::thread terminates
+        reader.join();
+        for (std::thread &parser : parsers)
+        {
+            parser.join();
+        }
+
+        if (failure)
+        {
+            std::rethrow_exception(failure);
+        }
+
+        stats.bytes = bytesRead;
+
+        return stats;
+    }
+}
+
+#endif // CUCKOOLOADER_HPP_INCLUDED
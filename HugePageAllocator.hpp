@@ -0,0 +1,293 @@
+/*
+    Data Structures
+    Project Hash: Cuckoo Hashing
+    Author: Anthony Lupica <arl127@uakron.edu> 2022
+
+    Header file for cuckoo::HugePageAllocator, an Allocator for CuckooHash that backs large tables
+    with huge pages and recycles the tables a rehash frees.
+
+    A random lookup in a table of several GB touches a different 4 KiB page almost every time, and
+    the page walk for the TLB miss costs about as much as the cache miss for the bucket itself. Mapped
+    in 2 MiB pages, the same table needs 512 times fewer TLB entries. Allocations of at least
+    HUGE_PAGE_BYTES are therefore mmap()ed, aligned to a huge page, and marked MADV_HUGEPAGE so that
+    the kernel backs them with transparent huge pages. Smaller ones come from allocateZeroed().
+
+    Ex.] Huge Page Tables
+    CuckooHash<std::uint64_t, int, cuckoo::Hash<std::uint64_t>, cuckoo::Equal<std::uint64_t>, 4,
+               cuckoo::Layout::AoS, 2, cuckoo::HugePageAllocator<unsigned char>> ids;
+
+    Deallocated mappings go to the allocator's HugePagePool instead of back to the OS, up to
+    HUGE_PAGE_POOL_BLOCKS of them, and an allocation of the same size takes one from there, already
+    faulted in, rather than mapping and faulting in fresh memory. Tables that shrink and grow back,
+    as in a daily batch cycle, then reuse the same pages. Copies of an allocator (and CuckooHash keeps
+    one) share its pool, so tables built with one allocator share their freed memory too.
+
+    Without mmap() (on Windows), or where the kernel has no MADV_HUGEPAGE, the allocator still pools,
+    over ordinary pages.
+*/
+
+#ifndef HUGEPAGEALLOCATOR_HPP_INCLUDED
+#define HUGEPAGEALLOCATOR_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "CuckooHash.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#endif
+
+namespace cuckoo
+{
+    // the huge page size HugePageAllocator maps in multiples of (2 MiB on x86-64, and on most arm64 kernels)
+    const std::size_t HUGE_PAGE_BYTES = std::size_t(1) << 21;
+
+    // freed mappings a HugePagePool keeps for reuse. One more unmaps the longest-kept one
+    const std::size_t HUGE_PAGE_POOL_BLOCKS = 8;
+
+    /* HugePagePool
+    *
+    *  the huge page mappings of a HugePageAllocator (and of its copies), and the freed ones kept for reuse.
+    *  Its members lock, so tables on different threads may share a pool.
+    */
+    class HugePagePool
+    {
+        private:
+
+            struct Block
+            {
+                void *memory;
+                std::size_t bytes; // mapped length, a multiple of HUGE_PAGE_BYTES
+            };
+
+            std::mutex mutex;
+            std::vector<Block> freed; // kept for reuse, the longest-kept first
+
+            static std::size_t mappedBytes(std::size_t bytes)      // bytes rounded up to whole huge pages
+            { return (bytes + HUGE_PAGE_BYTES - 1) / HUGE_PAGE_BYTES * HUGE_PAGE_BYTES; }
+            static void *map(std::size_t bytes);                   // zeroed memory on huge page boundaries
+            static void unmap(void *memory, std::size_t bytes);    // returns a mapping to the OS
+
+        public:
+
+            HugePagePool() = default;
+            HugePagePool(const HugePagePool &) = delete;
+            HugePagePool &operator=(const HugePagePool &) = delete;
+            ~HugePagePool()
+            { trim(); }
+
+            void *take(std::size_t bytes);                         // zeroed memory for at least bytes, reused if the pool holds a block of that size
+            void give(void *memory, std::size_t bytes);            // keeps memory returned by take(bytes) for reuse
+            void trim();                                           // returns every kept block to the OS
+            std::size_t pooled_bytes();                            // bytes kept for reuse
+    };
+
+    /* map()
+    *
+    *  maps bytes (a multiple of HUGE_PAGE_BYTES) of anonymous memory, which the OS hands out zeroed.
+    *  mmap() only aligns to ordinary pages, so one huge page more is mapped and the unaligned ends are
+    *  unmapped again, before the mapping is marked for transparent huge pages.
+    */
+    inline void *HugePagePool::map(std::size_t bytes)
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        void *mapping = ::mmap(nullptr, bytes + HUGE_PAGE_BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapping == MAP_FAILED)
+        {
+            throw std::bad_alloc();
+        }
+
+        unsigned char *start = static_cast<unsigned char *>(mapping);
+        unsigned char *aligned = reinterpret_cast<unsigned char *>((reinterpret_cast<std::uintptr_t>(start) + HUGE_PAGE_BYTES - 1) & ~(HUGE_PAGE_BYTES - 1));
+        if (aligned != start)
+        {
+            ::munmap(start, static_cast<std::size_t>(aligned - start));
+        }
+        std::size_t tail = static_cast<std::size_t>(start + HUGE_PAGE_BYTES - aligned);
+        if (tail > 0)
+        {
+            ::munmap(aligned + bytes, tail);
+        }
+
+#if defined(MADV_HUGEPAGE)
+        ::madvise(aligned, bytes, MADV_HUGEPAGE);
+#endif
+
+        return aligned;
+#else
+        return allocateZeroed(bytes, HUGE_PAGE_BYTES);
+#endif
+    }
+
+    /* unmap()
+    *
+    *  releases a mapping made by map()
+    */
+    inline void HugePagePool::unmap(void *memory, std::size_t bytes)
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        ::munmap(memory, bytes);
+#else
+        (void)bytes;
+        freeZeroed(memory);
+#endif
+    }
+
+    /* take()
+    *
+    *  a kept block of the mapped size of bytes, cleared (its pages stay faulted in, so clearing costs
+    *  far less than faulting in fresh ones), or else a new mapping
+    */
+    inline void *HugePagePool::take(std::size_t bytes)
+    {
+        std::size_t mapped = mappedBytes(bytes);
+        void *memory = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (std::size_t i = freed.size(); i-- > 0;)
+            {
+                if (freed[i].bytes == mapped)
+                {
+                    memory = freed[i].memory;
+                    freed.erase(freed.begin() + static_cast<std::ptrdiff_t>(i));
+                    break;
+                }
+            }
+        }
+
+        if (memory == nullptr)
+        {
+            return map(mapped);
+        }
+
+        std::memset(memory, 0, mapped);
+
+        return memory;
+    }
+
+    /* give()
+    *
+    *  keeps a block for the next take() of its size. A full pool first unmaps its longest-kept block.
+    */
+    inline void HugePagePool::give(void *memory, std::size_t bytes)
+    {
+        Block evicted = Block{ nullptr, 0 };
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (freed.size() >= HUGE_PAGE_POOL_BLOCKS)
+            {
+                evicted = freed.front();
+                freed.erase(freed.begin());
+            }
+            freed.push_back(Block{ memory, mappedBytes(bytes) });
+        }
+
+        if (evicted.memory != nullptr)
+        {
+            unmap(evicted.memory, evicted.bytes);
+        }
+    }
+
+    /* trim()
+    *
+    *  unmaps every kept block, e.g. once a table has settled at its final size
+    */
+    inline void HugePagePool::trim()
+    {
+        std::vector<Block> released;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            released.swap(freed);
+        }
+
+        for (const Block &block : released)
+        {
+            unmap(block.memory, block.bytes);
+        }
+    }
+
+    /* pooled_bytes()
+    *
+    *  the bytes of the kept blocks
+    */
+    inline std::size_t HugePagePool::pooled_bytes()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        std::size_t bytes = 0;
+        for (const Block &block : freed)
+        {
+            bytes += block.bytes;
+        }
+
+        return bytes;
+    }
+
+    /* HugePageAllocator
+    *
+    *  a standard allocator whose allocations of at least HUGE_PAGE_BYTES come from its HugePagePool.
+    *  All of its memory reads as zero when handed out, which it declares with "is_zeroing".
+    */
+    template <typename T>
+    class HugePageAllocator
+    {
+        private:
+
+            template <typename U>
+            friend class HugePageAllocator;
+
+            std::shared_ptr<HugePagePool> pool; // shared by every copy
+
+            static constexpr std::size_t ALIGNMENT = alignof(T) > alignof(std::max_align_t) ? alignof(T) : alignof(std::max_align_t);
+
+        public:
+
+            using value_type = T;
+            using is_zeroing = void;
+
+            HugePageAllocator()                                   // allocator with a pool of its own
+                : pool(std::make_shared<HugePagePool>()) {}
+            explicit HugePageAllocator(std::shared_ptr<HugePagePool> sharedPool) // allocator drawing on an existing pool
+                : pool(std::move(sharedPool)) {}
+            template <typename U>
+            HugePageAllocator(const HugePageAllocator<U> &other)  // rebinding copy, sharing other's pool
+                : pool(other.pool) {}
+
+            T *allocate(std::size_t n)
+            {
+                std::size_t bytes = n * sizeof(T);
+
+                return static_cast<T *>(bytes >= HUGE_PAGE_BYTES ? pool->take(bytes) : allocateZeroed(bytes, ALIGNMENT));
+            }
+            void deallocate(T *memory, std::size_t n)
+            {
+                std::size_t bytes = n * sizeof(T);
+                if (bytes >= HUGE_PAGE_BYTES)
+                {
+                    pool->give(memory, bytes);
+                }
+                else
+                {
+                    freeZeroed(memory);
+                }
+            }
+
+            const std::shared_ptr<HugePagePool> &memory_pool() const // getter for the pool, e.g. to trim() it
+            { return pool; }
+
+            template <typename U>
+            bool operator==(const HugePageAllocator<U> &other) const
+            { return pool == other.pool; }
+            template <typename U>
+            bool operator!=(const HugePageAllocator<U> &other) const
+            { return pool != other.pool; }
+    };
+}
+
+#endif // HUGEPAGEALLOCATOR_HPP_INCLUDED
@@ -0,0 +1,258 @@
+/*
+    Data Structures
+    Project Hash: Cuckoo Hashing
+    Author: Anthony Lupica <arl127@uakron.edu> 2022
+
+    Header file for cuckoo::NumaAllocator, an Allocator for CuckooHash that places a table's memory on
+    chosen NUMA nodes.
+
+    On a multi-socket host, memory belongs to the node whose socket first touched it, so the tables of
+    a CuckooHash end up wherever the thread that built (or last rehashed) them happened to run, and
+    every lookup from the other sockets crosses the interconnect. A NumaAllocator maps its allocations
+    with mmap() and sets their memory policy with mbind() before any page is touched:
+
+    - cuckoo::NumaPolicy::Interleave spreads the pages round-robin over all nodes, so a table shared by
+      every socket costs each of them the same, and no one node's memory bandwidth is the bottleneck.
+    - cuckoo::NumaPolicy::Preferred places the pages on one node (falling back to others once it is full),
+      for a table used by the threads of that node, as the replicas of ReplicatedCuckooHash are.
+    - cuckoo::NumaPolicy::Bind places them on one node only. An allocation the kernel refuses to place
+      so (a node that does not exist, or no NUMA support) throws std::bad_alloc.
+    - cuckoo::NumaPolicy::FirstTouch leaves the kernel's default placement.
+
+    Ex.] Interleaved Table
+    CuckooHash<std::uint64_t, int, cuckoo::Hash<std::uint64_t>, cuckoo::Equal<std::uint64_t>, 4,
+               cuckoo::Layout::AoS, 2, cuckoo::NumaAllocator<unsigned char>> ids(
+        cuckoo::NumaAllocator<unsigned char>(cuckoo::NumaPolicy::Interleave));
+
+    The policy travels with the allocator, so the tables a rehash allocates land on the same nodes.
+    The system call is made directly, without a libnuma dependency. Allocations below NUMA_MIN_BYTES,
+    where a page of their own would be wasted, come from allocateZeroed(), as does everything on
+    systems without mbind() (anything but Linux), where the allocator makes no placement at all.
+*/
+
+#ifndef NUMAALLOCATOR_HPP_INCLUDED
+#define NUMAALLOCATOR_HPP_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <new>
+#include <string>
+
+#include "CuckooHash.hpp"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace cuckoo
+{
+    // where a NumaAllocator places its memory
+    enum class NumaPolicy : std::uint8_t
+    {
+        FirstTouch, // the kernel's default: on the node of the thread that first writes a page
+        Interleave, // round-robin over every node
+        Preferred,  // on the allocator's node, falling back to other nodes when it has no free memory
+        Bind        // on the allocator's node only
+    };
+
+    // allocations of a NumaAllocator smaller than this come from allocateZeroed() and are not placed
+    const std::size_t NUMA_MIN_BYTES = std::size_t(1) << 16;
+
+    // the most nodes the node masks passed to mbind() describe
+    const std::size_t NUMA_MAX_NODES = 64;
+
+    /* numaNodeCount()
+    *
+    *  the number of NUMA nodes, one more than the highest node listed in /sys/devices/system/node/online
+    *  (e.g. "0-1"), read once. 1 where there is no such file.
+    */
+    inline std::size_t numaNodeCount()
+    {
+        static const std::size_t nodes = []
+        {
+            std::ifstream online("/sys/devices/system/node/online");
+            std::string ranges;
+            std::size_t highest = 0;
+            if (online >> ranges)
+            {
+                std::size_t number = 0;
+                for (char c : ranges)
+                {
+                    if (c >= '0' && c <= '9')
+                    {
+                        number = number * 10 + static_cast<std::size_t>(c - '0');
+                        highest = number > highest ? number : highest;
+                    }
+                    else
+                    {
+                        number = 0;
+                    }
+                }
+            }
+
+            return highest + 1 < NUMA_MAX_NODES ? highest + 1 : NUMA_MAX_NODES;
+        }();
+
+        return nodes;
+    }
+
+    /* currentNumaNode()
+    *
+    *  the node of the CPU the calling thread runs on (0 where the OS does not say). A thread the
+    *  scheduler may move is only known to have been there, so callers that care pin their threads.
+    */
+    inline std::size_t currentNumaNode()
+    {
+#if defined(__linux__) && defined(SYS_getcpu)
+        unsigned cpu = 0;
+        unsigned node = 0;
+        if (::syscall(SYS_getcpu, &cpu, &node, nullptr) == 0 && node < numaNodeCount())
+        {
+            return node;
+        }
+#endif
+        return 0;
+    }
+
+    /* NumaAllocator
+    *
+    *  a standard allocator whose allocations of at least NUMA_MIN_BYTES are mapped and placed by its
+    *  NumaPolicy (and node, for Preferred and Bind). All of its memory reads as zero when handed out,
+    *  which it declares with "is_zeroing".
+    */
+    template <typename T>
+    class NumaAllocator
+    {
+        private:
+
+            template <typename U>
+            friend class NumaAllocator;
+
+            NumaPolicy policy;
+            std::size_t node; // the node of Preferred and Bind
+
+            static constexpr std::size_t ALIGNMENT = alignof(T) > alignof(std::max_align_t) ? alignof(T) : alignof(std::max_align_t);
+
+            void *map(std::size_t bytes) const;                    // zeroed, placed memory of bytes (rounded up to pages)
+            static void unmap(void *memory, std::size_t bytes);    // releases memory returned by map(bytes)
+
+        public:
+
+            using value_type = T;
+            using is_zeroing = void;
+
+            explicit NumaAllocator(NumaPolicy placement = NumaPolicy::FirstTouch, std::size_t nodeIndex = 0) // allocator placing memory by placement
+                : policy(placement), node(nodeIndex) {}
+            template <typename U>
+            NumaAllocator(const NumaAllocator<U> &other)          // rebinding copy, with other's placement
+                : policy(other.policy), node(other.node) {}
+
+            T *allocate(std::size_t n)
+            {
+                std::size_t bytes = n * sizeof(T);
+
+                return static_cast<T *>(bytes >= NUMA_MIN_BYTES ? map(bytes) : allocateZeroed(bytes, ALIGNMENT));
+            }
+            void deallocate(T *memory, std::size_t n)
+            {
+                std::size_t bytes = n * sizeof(T);
+                if (bytes >= NUMA_MIN_BYTES)
+                {
+                    unmap(memory, bytes);
+                }
+                else
+                {
+                    freeZeroed(memory);
+                }
+            }
+
+            NumaPolicy placement() const                          // getter for the policy
+            { return policy; }
+            std::size_t numa_node() const                         // getter for the node of Preferred and Bind
+            { return node; }
+
+            template <typename U>
+            bool operator==(const NumaAllocator<U> &other) const
+            { return policy == other.policy && node == other.node; }
+            template <typename U>
+            bool operator!=(const NumaAllocator<U> &other) const
+            { return !(*this == other); }
+    };
+
+    /* map()
+    *
+    *  maps anonymous memory, which the OS hands out zeroed and places only once a page is first touched,
+    *  and sets the policy that placement follows. A failed mbind() (a kernel without NUMA support, or a
+    *  node that does not exist, including one past NUMA_MAX_NODES that no node mask can name) leaves the
+    *  memory usable, just not placed, except under Bind, which promises the node: there the memory is
+    *  unmapped again and std::bad_alloc thrown.
+    */
+    template <typename T>
+    void *NumaAllocator<T>::map(std::size_t bytes) const
+    {
+#if defined(__linux__)
+        void *memory = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED)
+        {
+            throw std::bad_alloc();
+        }
+
+#if defined(SYS_mbind)
+        // the MPOL_ modes of <linux/mempolicy.h>
+        const int PREFERRED = 1;
+        const int BIND = 2;
+        const int INTERLEAVE = 3;
+
+        unsigned long nodeMask = 0;
+        int mode = 0;
+        switch (policy)
+        {
+            case NumaPolicy::Interleave:
+                nodeMask = numaNodeCount() >= NUMA_MAX_NODES ? ~0UL : (1UL << numaNodeCount()) - 1;
+                mode = INTERLEAVE;
+                break;
+            case NumaPolicy::Preferred:
+            case NumaPolicy::Bind:
+                if (node < NUMA_MAX_NODES)
+                {
+                    nodeMask = 1UL << node;
+                    mode = policy == NumaPolicy::Bind ? BIND : PREFERRED;
+                }
+                break;
+            case NumaPolicy::FirstTouch:
+                break;
+        }
+        bool placed = mode != 0 && ::syscall(SYS_mbind, memory, bytes, mode, &nodeMask, NUMA_MAX_NODES + 1, 0) == 0;
+        if (policy == NumaPolicy::Bind && !placed)
+        {
+            ::munmap(memory, bytes);
+            throw std::bad_alloc();
+        }
+#endif
+
+        return memory;
+#else
+        return allocateZeroed(bytes, ALIGNMENT);
+#endif
+    }
+
+    /* unmap()
+    *
+    *  releases memory returned by map()
+    */
+    template <typename T>
+    void NumaAllocator<T>::unmap(void *memory, std::size_t bytes)
+    {
+#if defined(__linux__)
+        ::munmap(memory, bytes);
+#else
+        (void)bytes;
+        freeZeroed(memory);
+#endif
+    }
+}
+
+#endif // NUMAALLOCATOR_HPP_INCLUDED
@@ -0,0 +1,241 @@
+/*
+    Data Structures
+    Project Hash: Cuckoo Hashing
+    Author: Anthony Lupica <arl127@uakron.edu> 2022
+
+    Header file for ReplicatedCuckooHash, a read-mostly table that keeps a copy of its records on every
+    NUMA node, so that lookups never leave their own node's memory.
+
+    One writer thread modifies the primary() table, a CuckooHash like any other, and calls publish() to
+    make its changes visible. publish() copies the records into one new replica per node, each allocated
+    on that node (through a cuckoo::NumaAllocator, see NumaAllocator.hpp), swaps them in, and advances
+    the epoch. Any number of reader threads look records up through a Reader of their own, which holds the
+    replica of its node: on every lookup it compares the epoch it read the replica at with the current one
+    (a load of one atomic, which stays cached on every node until the next publish()), and fetches the new
+    replica only once the epoch has moved on.
+
+    Ex.] Shared Birth Years
+    ReplicatedCuckooHash<std::uint64_t, int> birthYears;
+    birthYears.primary().insert(42, 1963);  // on the writer thread
+    birthYears.publish();
+    auto reader = birthYears.reader();      // on each reader thread
+    int year = 0;
+    if (reader.search(42, year)) ...
+
+    Readers never wait on the writer, nor the writer on readers: a replica is never modified once
+    published, and a replaced one is freed when the last Reader holding it moves on to a newer epoch
+    (or is destroyed). Until then the old replica keeps its memory, so a Reader left idle pins it;
+    release() lets go. A Reader's node is that of the thread that created it, so reader threads should
+    be pinned to their node (e.g. with taskset or pthread_setaffinity_np()).
+
+    The primary table is interleaved over all nodes, as the writer is on one node and publish() reads it
+    from all of them. publish() costs a full copy of the records per node, so the mode pays off when
+    lookups far outnumber publishes. On a single-node host there is one replica, and the Reader still
+    decouples readers from the writer. The replicas are read by many threads at once, so their stats()
+    counters (with CUCKOO_STATS) are not meaningful; the primary's are.
+
+    The Table template parameter is the table type, by default a CuckooHash of 4 slots per bucket (which
+    fills to 90% before it grows, where 1 slot grows at 50% and so doubles the memory of every replica)
+    whose Allocator is a NumaAllocator. With any other allocator the replicas are allocated without
+    placement.
+*/
+
+#ifndef REPLICATEDCUCKOOHASH_HPP_INCLUDED
+#define REPLICATEDCUCKOOHASH_HPP_INCLUDED
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "CuckooHash.hpp"
+#include "NumaAllocator.hpp"
+
+template <typename Key, typename Value,
+          typename Table = CuckooHash<Key, Value, cuckoo::Hash<Key>, cuckoo::Equal<Key>, 4, cuckoo::Layout::AoS, 2, cuckoo::NumaAllocator<unsigned char>>>
+class ReplicatedCuckooHash
+{
+    static_assert(std::is_same<typename Table::key_type, Key>::value && std::is_same<typename Table::mapped_type, Value>::value,
+                  "Table must be a CuckooHash of Key and Value");
+
+    private:
+
+        // private data members
+        Table primaryTable;                               // the writer's table
+        std::vector<std::shared_ptr<const Table>> replicas; // the published copy of each node, replaced whole by publish()
+        std::atomic<std::uint64_t> currentEpoch;          // publish() calls so far
+        std::size_t threadCount;                          // threads publish() may use
+
+        // private methods
+        static typename Table::allocator_type allocatorFor(cuckoo::NumaPolicy policy, std::size_t node); // a table allocator placing by policy, if it can
+
+    public:
+
+        using key_type = Key;      // the Key template parameter
+        using mapped_type = Value; // the Value template parameter
+
+        /* Reader
+        *
+        *  one reader thread's view of a ReplicatedCuckooHash: the replica of its node, as of some epoch.
+        *  Each lookup first moves the view to the current epoch. A Reader must not be shared between
+        *  threads, nor outlive its table.
+        */
+        class Reader
+        {
+            private:
+
+                const ReplicatedCuckooHash *owner;  // the table read
+                std::size_t node;                   // the node whose replica is read
+                std::shared_ptr<const Table> held;  // that replica, as of seenEpoch
+                std::uint64_t seenEpoch;            // the epoch held was fetched at
+
+            public:
+
+                Reader(const ReplicatedCuckooHash &table, std::size_t nodeIndex) // a reader of the replica of nodeIndex
+                    : owner(&table), node(nodeIndex < table.replicas.size() ? nodeIndex : 0), held(), seenEpoch(~std::uint64_t(0)) {}
+
+                const Table &snapshot()                   // the current replica, which stays valid (and unchanged) until the next call on this Reader
+                {
+                    std::uint64_t epoch = owner->currentEpoch.load(std::memory_order_acquire);
+                    if (epoch != seenEpoch)
+                    {
+                        held = std::atomic_load(&owner->replicas[node]);
+                        seenEpoch = epoch;
+                    }
+                    return *held;
+                }
+                bool search(const Key &key, Value &value) // copy a record's value into value, false if absent
+                {
+                    const Value *found = snapshot().search(key);
+                    if (found == nullptr)
+                    {
+                        return false;
+                    }
+                    value = *found;
+                    return true;
+                }
+                const Value *find(const Key &key)         // search() returning a pointer into the replica (nullptr if absent), valid until the next call
+                { return snapshot().search(key); }
+                bool contains(const Key &key)             // find if the table contains a record
+                { return snapshot().contains(key); }
+                void release()                            // let go of the held replica, e.g. before idling
+                {
+                    held.reset();
+                    seenEpoch = ~std::uint64_t(0);
+                }
+                std::uint64_t epoch() const               // getter for the epoch of the held replica
+                { return seenEpoch; }
+                std::size_t numa_node() const             // getter for the node read
+                { return node; }
+        };
+
+        // ctors
+        ReplicatedCuckooHash();                                         // an empty primary, and an empty replica on every node
+        ReplicatedCuckooHash(const ReplicatedCuckooHash &) = delete;    // tables are owned, copying is not supported
+        ReplicatedCuckooHash &operator=(const ReplicatedCuckooHash &) = delete;
+
+        // public methods
+        Table &primary()                                  // the table the writer modifies. Readers see its changes after publish()
+        { return primaryTable; }
+        const Table &primary() const                      // const getter for the primary table
+        { return primaryTable; }
+        std::uint64_t publish();                          // copy the primary to every node and swap the copies in, returns the new epoch
+        Reader reader() const                             // a Reader of the replica of the calling thread's node
+        { return Reader(*this, cuckoo::currentNumaNode()); }
+        Reader reader(std::size_t node) const             // a Reader of the replica of node
+        { return Reader(*this, node); }
+        std::uint64_t epoch() const                       // getter for the number of publish() calls
+        { return currentEpoch.load(std::memory_order_acquire); }
+        std::size_t node_count() const                    // getter for the number of replicas, one per node
+        { return replicas.size(); }
+        void set_thread_count(std::size_t threads)        // threads publish() may use (at least 1)
+        { threadCount = threads > 0 ? threads : 1; }
+        std::size_t thread_count() const                  // getter for the thread count
+        { return threadCount; }
+};
+
+/* Default Constructor
+*
+*  an empty primary, interleaved over the nodes, and an empty replica on each node, at epoch 0
+*/
+template <typename Key, typename Value, typename Table>
+ReplicatedCuckooHash<Key, Value, Table>::ReplicatedCuckooHash()
+    : primaryTable(allocatorFor(cuckoo::NumaPolicy::Interleave, 0)), replicas(cuckoo::numaNodeCount()), currentEpoch(0),
+      threadCount(std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1)
+{
+    for (std::size_t node = 0; node < replicas.size(); ++node)
+    {
+        replicas[node] = std::make_shared<const Table>(allocatorFor(cuckoo::NumaPolicy::Preferred, node));
+    }
+}
+
+/* publish()
+*
+*  copies the records of the primary (with their hash codes, computed once) and builds a replica from
+*  them for every node, the nodes' replicas in parallel. Each replica takes the primary's load policy
+*  and filter setting, and is reserved for exactly its records, as it never grows. Once all are built
+*  they replace the published ones, and the epoch advances, after which every Reader's next lookup
+*  fetches the new replica of its node. Called by the writer only.
+*/
+template <typename Key, typename Value, typename Table>
+std::uint64_t ReplicatedCuckooHash<Key, Value, Table>::publish()
+{
+    std::vector<std::pair<Key, Value>> records;
+    records.reserve(primaryTable.size());
+    primaryTable.for_each([&](const Key &key, const Value &value)
+    {
+        records.emplace_back(key, value);
+    });
+
+    std::vector<std::uint64_t> hashCodes(records.size());
+    for (std::size_t i = 0; i < records.size(); ++i)
+    {
+        hashCodes[i] = primaryTable.hash_code(records[i].first);
+    }
+
+    std::size_t nodes = replicas.size();
+    std::vector<std::shared_ptr<Table>> built(nodes);
+    cuckoo::runParallel(nodes, [&](std::size_t node)
+    {
+        std::shared_ptr<Table> replica = std::make_shared<Table>(allocatorFor(cuckoo::NumaPolicy::Preferred, node));
+        replica->set_thread_count(std::max<std::size_t>(1, threadCount / nodes));
+        replica->set_load_policy(primaryTable.load_policy());
+        replica->set_filter(primaryTable.filtered());
+        replica->reserve(records.size());
+        replica->build(records.begin(), records.end(), hashCodes.data());
+        built[node] = std::move(replica);
+    });
+
+    for (std::size_t node = 0; node < nodes; ++node)
+    {
+        std::atomic_store(&replicas[node], std::shared_ptr<const Table>(std::move(built[node])));
+    }
+
+    return currentEpoch.fetch_add(1, std::memory_order_acq_rel) + 1;
+}
+
+/* allocatorFor()
+*
+*  a NumaAllocator with the policy and node for a Table that takes one, else a default allocator
+*/
+template <typename Key, typename Value, typename Table>
+typename Table::allocator_type ReplicatedCuckooHash<Key, Value, Table>::allocatorFor(cuckoo::NumaPolicy policy, std::size_t node)
+{
+    if constexpr (std::is_constructible<typename Table::allocator_type, cuckoo::NumaPolicy, std::size_t>::value)
+    {
+        return typename Table::allocator_type(policy, node);
+    }
+    else
+    {
+        (void)policy;
+        (void)node;
+        return typename Table::allocator_type();
+    }
+}
+
+#endif // REPLICATEDCUCKOOHASH_HPP_INCLUDED
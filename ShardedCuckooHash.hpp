@@ -0,0 +1,541 @@
+/*
+    Data Structures
+    Project Hash: Cuckoo Hashing
+    Author: Anthony Lupica <arl127@uakron.edu> 2022
+
+    Header file for ShardedCuckooHash, a thread-safe front-end that splits the records over
+    ShardCount independent CuckooHash tables.
+
+    Any number of threads may call insert(), search(), contains(), remove() and the batch versions on
+    one table. Each key belongs to one shard, picked from the top bits of its hash code remixed with
+    SHARD_SEED (the hash code's own top bits already choose the key's table 2 bucket, so all keys of a
+    shard would share them). Every shard is a CuckooHash with a mutex of its own, its own memory and its
+    own resize schedule: a thread holds one shard's lock for one operation, and a rehash of one shard
+    stalls only the threads waiting for that shard. With many more shards than threads, writers rarely
+    meet, and write throughput scales with the threads without a concurrent table.
+
+    Ex.] Shared Birth Years
+    ShardedCuckooHash<std::string, int, 64> birthYears;
+    birthYears.insert("Brad Pitt", 1963);   // from any thread
+    int year = 0;
+    if (birthYears.search("Brad Pitt", year)) ...
+
+    The Table template parameter is the shard type, CuckooHash<Key, Value> by default, so any bucket
+    size, layout, table count or allocator carries over. Results are returned rather than printed, as
+    in ConcurrentCuckooHash: search() copies the value out, since a pointer into a shard would outlive
+    its lock.
+
+    build() bulk loads a batch shard-parallel: the keys are hashed and sorted into their shards on
+    thread_count() threads, and each thread then builds whole shards, one at a time. for_each() visits
+    the shards the same way, and stats() sums the shards' snapshots.
+*/
+
+#ifndef SHARDEDCUCKOOHASH_HPP_INCLUDED
+#define SHARDEDCUCKOOHASH_HPP_INCLUDED
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "CuckooHash.hpp"
+
+namespace cuckoo
+{
+    // remixes a hash code before its top bits pick a shard, so that the shard does not decide table positions
+    const std::uint64_t SHARD_SEED = 0x9e3779b97f4a7c15ULL;
+
+    /* addMetrics()
+    *
+    *  adds the counts of one Metrics to another (the longest rehash is the longer of both)
+    */
+    inline void addMetrics(Metrics &total, const Metrics &part)
+    {
+        total.hits += part.hits;
+        total.misses += part.misses;
+        total.probes += part.probes;
+        total.stashHits += part.stashHits;
+        total.filterRejects += part.filterRejects;
+        total.duplicates += part.duplicates;
+        for (std::size_t i = 0; i < PATH_HISTOGRAM_BINS; ++i)
+        {
+            total.pathLengths[i] += part.pathLengths[i];
+        }
+        total.pathFailures += part.pathFailures;
+        total.rehashes += part.rehashes;
+        total.migrations += part.migrations;
+        total.rehashNanoseconds += part.rehashNanoseconds;
+        total.longestRehashNanoseconds = std::max(total.longestRehashNanoseconds, part.longestRehashNanoseconds);
+        for (std::size_t i = 0; i < LATENCY_HISTOGRAM_BINS; ++i)
+        {
+            total.insertLatency[i] += part.insertLatency[i];
+        }
+    }
+}
+
+template <typename Key, typename Value, std::size_t ShardCount = 16, typename Table = CuckooHash<Key, Value>>
+class ShardedCuckooHash
+{
+    static_assert(ShardCount >= 1, "ShardCount must be at least 1");
+    static_assert(std::is_same<typename Table::key_type, Key>::value && std::is_same<typename Table::mapped_type, Value>::value,
+                  "Table must be a CuckooHash of Key and Value");
+
+    private:
+
+        // one table and its lock, on cache lines of their own so that threads working on neighbouring shards do not share a line
+        struct alignas(cuckoo::CACHE_LINE) Shard
+        {
+            mutable std::mutex mutex; // held for every operation on table
+            Table table;              // the shard's records
+        };
+
+        // private data members
+        std::unique_ptr<Shard[]> shards; // the ShardCount shards
+        std::size_t threadCount;         // threads build() and for_each() may use
+
+        // private methods
+        std::size_t shardOf(std::uint64_t hashCode) const                  // the shard of a hash code
+        { return cuckoo::fastRange(static_cast<std::uint32_t>(cuckoo::mixInt(hashCode, cuckoo::SHARD_SEED) >> 32), static_cast<std::uint32_t>(ShardCount)); }
+        template <typename K>
+        Shard &shardFor(const K &key) const                                 // the shard holding key
+        { return shards[shardOf(shards[0].table.hash_code(key))]; }
+        template <typename Function>
+        void forEachShard(Function work) const;                             // runs work(shard index) for every shard, shard-parallel
+        std::size_t partsFor(std::size_t count) const;                      // threads for a pass over count items
+
+    public:
+
+        using key_type = Key;      // the Key template parameter
+        using mapped_type = Value; // the Value template parameter
+
+        // ctors
+        ShardedCuckooHash();                                  // ShardCount empty shards
+        ShardedCuckooHash(const ShardedCuckooHash &) = delete; // shards are owned, copying is not supported
+        ShardedCuckooHash &operator=(const ShardedCuckooHash &) = delete;
+
+        // public methods
+        bool insert(const Key &key, const Value &value);      // insert into the hash table, false if the key already exists
+        cuckoo::Status insert_or_assign(const Key &key, const Value &value); // insert a record, or replace the value of the key's record
+        bool search(const Key &key, Value &value) const;      // copy a record's value into value, false if absent
+        bool contains(const Key &key) const;                  // find if the hash table contains a record
+        bool remove(const Key &key);                          // remove a record from the hash table, false if absent
+        std::size_t insert_batch(const Key *keys, const Value *values, std::size_t count, cuckoo::Status *out = nullptr); // insert() for count records, returns the number added
+        std::size_t remove_batch(const Key *keys, std::size_t count, cuckoo::Status *out = nullptr);                      // remove() for count keys, returns the number removed
+        template <typename RandomIt>
+        std::size_t build(RandomIt first, RandomIt last);     // bulk load a range of key - value pairs shard-parallel, returns the number added
+        template <typename Function>
+        void for_each(Function visit) const;                  // call visit(key, value) for every record, from several threads at once
+        std::size_t size() const;                             // getter for the number of records of all shards
+        void reserve(std::size_t count);                      // pre-size every shard for its share of count records
+        void shrink_to_fit();                                 // shrink_to_fit() every shard
+        void set_incremental_resize(bool enabled);            // set_incremental_resize() of every shard
+        void set_filter(bool enabled);                        // set_filter() of every shard
+        void set_thread_count(std::size_t threads)            // threads build() and for_each() may use (at least 1)
+        { threadCount = threads > 0 ? threads : 1; }
+        std::size_t thread_count() const                      // getter for the thread count
+        { return threadCount; }
+        static constexpr std::size_t shard_count()            // getter for ShardCount
+        { return ShardCount; }
+        template <typename Function>
+        auto with_shard(std::size_t shard, Function work) -> decltype(work(std::declval<Table &>())) // run work(table) on one shard under its lock
+        {
+            std::lock_guard<std::mutex> lock(shards[shard].mutex);
+            return work(shards[shard].table);
+        }
+
+        // the shards' snapshots, summed
+        struct Stats
+        {
+            std::size_t records;       // size()
+            std::size_t smallestShard; // records of the emptiest shard
+            std::size_t largestShard;  // records of the fullest shard
+            double loadFactor;         // the mean load factor of the shards
+            double largestLoad;        // the highest load factor of a shard
+            std::size_t stashed;       // records held in the shards' stashes
+            std::size_t resizingShards; // shards with an incremental resize in progress
+            std::size_t filterBytes;   // memory of the shards' filters
+            bool instrumented;         // true when compiled with CUCKOO_STATS, and metrics holds counts
+            cuckoo::Metrics metrics;   // the shards' operation counters, added up
+        };
+        Stats stats() const;                                  // getter for the snapshot, taking one shard's lock at a time
+};
+
+/* Default Constructor
+*
+*  ShardCount empty shards, with build() and for_each() using every hardware thread. Each shard runs
+*  its own build() and rehash() on one thread, since the shards already keep the threads busy.
+*/
+template <typename Key, typename Value, std::size_t ShardCount, typename Table>
+ShardedCuckooHash<Key, Value, ShardCount, Table>::ShardedCuckooHash()
+    : shards(new Shard[ShardCount]), threadCount(std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1)
+{
+    for (std::size_t s = 0; s < ShardCount; ++s)
+    {
+        shards[s].table.set_thread_count(1);
+    }
+}
+
+/* insert()
+*
+*  adds the record to its shard unless the key exists. Nothing is logged.
+*/
+template <typename Key, typename Value, std::size_t ShardCount, typename Table>
+bool ShardedCuckooHash<Key, Value, ShardCount, Table>::insert(const Key &key, const Value &value)
+{
+    Shard &shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    return shard.table.insert_batch(&key, &value, 1) == 1;
+}
+
+/* insert_or_assign()
+*
+*  CuckooHash::insert_or_assign() on the key's shard
+*/
+template <typename Key, typename Value, std::size_t ShardCount, typename Table>
+cuckoo::Status ShardedCuckooHash<Key, Value, ShardCount, Table>::insert_or_assign(const Key &key, const Value &value)
+{
+    Shard &shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    return shard.table.insert_or_assign(key, value);
+}
+
+/* search()
+*
+*  copies the value of the key's record into value while its shard is locked. Returns false, leaving
+*  value unchanged, if the key is absent.
+*/
+template <typename Key, typename Value, std::size_t ShardCount, typename Table>
+bool ShardedCuckooHash<Key, Value, ShardCount, Table>::search(const Key &key, Value &value) const
+{
+    Shard &shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    const Value *found = static_cast<const Table &>(shard.table).search(key);
+    if (found == nullptr)
+    {
+        return false;
+    }
+    value = *found;
+
+    return true;
+}
+
+/* contains()
+*
+*  returns true if the key is found in its shard, and false otherwise
+*/
+template <typename Key, typename Value, std::size_t ShardCount, typename Table>
+bool ShardedCuckooHash<Key, Value, ShardCount, Table>::contains(const Key &key) const
+{
+    Shard &shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    return shard.table.contains(key);
+}
+
+/* remove()
+*
+*  deletes the key's record from its shard. Returns false, logging nothing, if the key is absent.
+*/
+template <typename Key, typename Value, std::size_t ShardCount, typename Table>
+bool ShardedCuckooHash<Key, Value, ShardCount, Table>::remove(const Key &key)
+{
+    Shard &shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    return shard.table.remove_batch(&key, 1) == 1;
+}
+
+/* insert_batch()
+*
+*  insert() for keys[0] to keys[count - 1], storing each record's status in out (unless out is nullptr),
+*  one shard lock per record. Returns the number of records added.
+*/
+template <typename Key, typename Value, std::size_t ShardCount, typename Table>
+std::size_t ShardedCuckooHash<Key, Value, ShardCount, Table>::insert_batch(const Key *keys, const Value *values, std::size_t count, cuckoo::Status *out)
+{
+    std::size_t added = 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        Shard &shard = shardFor(keys[i]);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        cuckoo::Status status = cuckoo::Status::Failed;
+        shard.table.insert_batch(keys + i, values + i, 1, &status);
+        added += status == cuckoo::Status::Inserted ? 1 : 0;
+        if (out != nullptr)
+        {
+            out[i] = status;
+        }
+    }
+
+    return added;
+}
+
+/* remove_batch()
+*
+*  remove() for keys[0] to keys[count - 1], storing cuckoo::Status::Removed or Missing for each key in out
+*  (unless out is nullptr). Returns the number of records removed.
+*/
+template <typename Key, typename Value, std::size_t ShardCount, typename Table>
+std::size_t ShardedCuckooHash<Key, Value, ShardCount, Table>::remove_batch(const Key *keys, std::size_t count, cuckoo::Status *out)
+{
+    std::size_t removed = 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        Shard &shard = shardFor(keys[i]);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        cuckoo::Status status = cuckoo::Status::Missing;
+        shard.table.remove_batch(keys + i, 1, &status);
+        removed += status == cuckoo::Status::Removed ? 1 : 0;
+        if (out != nullptr)
+        {
+            out[i] = status;
+        }
+    }
+
+    return removed;
+}
+
+/* build()
+*
+*  bulk loads the key - value pairs of the random access range [first, last). The keys are hashed,
+*  and each record's position is counted into its shard's run of one array, in parallel over parts
+*  of the batch. Then every shard copies its run (with the hash codes) and hands it to its own build(),
+*  with the shards divided among the threads. As with CuckooHash::build(), a key already in the table,
+*  or repeated in the batch, keeps its first value. Returns the number of records added.
+*/
+template <typename Key, typename Value, std::size_t ShardCount, typename Table>
+template <typename RandomIt>
+std::size_t ShardedCuckooHash<Key, Value, ShardCount, Table>::build(RandomIt first, RandomIt last)
+{
+    static_assert(std::is_base_of<std::random_access_iterator_tag, typename std::iterator_traits<RandomIt>::iterator_category>::value,
+                  "build() needs a random access range");
+
+    std::size_t count = static_cast<std::size_t>(last - first);
+    std::size_t parts = partsFor(count);
+
+    // hash every key, and count the records of each shard within each part
+    std::vector<std::uint64_t> hashCodes(count);
+    std::vector<std::uint32_t> shardIds(count);
+    std::vector<std::vector<std::size_t>> partCounts(parts, std::vector<std::size_t>(ShardCount, 0));
+    cuckoo::runParallel(parts, [&](std::size_t part)
+    {
+        for (std::size_t i = part * count / parts; i < (part + 1) * count / parts; ++i)
+        {
+            hashCodes[i] = shards[0].table.hash_code(first[i].first);
+            shardIds[i] = static_cast<std::uint32_t>(shardOf(hashCodes[i]));
+            ++partCounts[part][shardIds[i]];
+        }
+    });
+
+    // each shard's run starts after those of the shards before it, and within the run the parts follow in
+    // batch order, so a shard sees its records in the order of the batch
+    std::vector<std::size_t> runStart(ShardCount + 1, 0);
+    std::vector<std::vector<std::size_t>> partStart(parts, std::vector<std::size_t>(ShardCount, 0));
+    for (std::size_t s = 0; s < ShardCount; ++s)
+    {
+        std::size_t next = runStart[s];
+        for (std::size_t part = 0; part < parts; ++part)
+        {
+            partStart[part][s] = next;
+            next += partCounts[part][s];
+        }
+        runStart[s + 1] = next;
+    }
+
+    std::vector<std::size_t> order(count);
+    cuckoo::runParallel(parts, [&](std::size_t part)
+    {
+        std::vector<std::size_t> &next = partStart[part];
+        for (std::size_t i = part * count / parts; i < (part + 1) * count / parts; ++i)
+        {
+            order[next[shardIds[i]]++] = i;
+        }
+    });
+
+    std::atomic<std::size_t> added(0);
+    forEachShard([&](std::size_t s)
+    {
+        std::vector<std::pair<Key, Value>> records;
+        std::vector<std::uint64_t> codes;
+        records.reserve(runStart[s + 1] - runStart[s]);
+        codes.reserve(runStart[s + 1] - runStart[s]);
+        for (std::size_t r = runStart[s]; r < runStart[s + 1]; ++r)
+        {
+            records.emplace_back(first[order[r]].first, first[order[r]].second);
+            codes.push_back(hashCodes[order[r]]);
+        }
+
+        std::lock_guard<std::mutex> lock(shards[s].mutex);
+        added += shards[s].table.build(records.begin(), records.end(), codes.data());
+    });
+
+    return added;
+}
+
+/* for_each()
+*
+*  calls visit(key, value) for every record. The shards are divided among thread_count() threads, and each
+*  visits the records of one shard at a time, with that shard locked, so visit is called from several
+*  threads at once (never twice at once for one shard) and must be safe to call so.
+*/
+template <typename Key, typename Value, std::size_t ShardCount, typename Table>
+template <typename Function>
+void ShardedCuckooHash<Key, Value, ShardCount, Table>::for_each(Function visit) const
+{
+    forEachShard([&](std::size_t s)
+    {
+        std::lock_guard<std::mutex> lock(shards[s].mutex);
+        shards[s].table.for_each(visit);
+    });
+}
+
+/* size()
+*
+*  the records of all shards, counted one shard at a time (so under concurrent writes, only approximately)
+*/
+template <typename Key, typename Value, std::size_t ShardCount, typename Table>
+std::size_t ShardedCuckooHash<Key, Value, ShardCount, Table>::size() const
+{
+    std::size_t records = 0;
+    for (std::size_t s = 0; s < ShardCount; ++s)
+    {
+        std::lock_guard<std::mutex> lock(shards[s].mutex);
+        records += shards[s].table.size();
+    }
+
+    return records;
+}
+
+/* reserve()
+*
+*  pre-sizes every shard for an even share of count records, plus an eighth for the unevenness of the split
+*/
+template <typename Key, typename Value, std::size_t ShardCount, typename Table>
+void ShardedCuckooHash<Key, Value, ShardCount, Table>::reserve(std::size_t count)
+{
+    std::size_t share = count / ShardCount + count / ShardCount / 8 + 1;
+    forEachShard([&](std::size_t s)
+    {
+        std::lock_guard<std::mutex> lock(shards[s].mutex);
+        shards[s].table.reserve(share);
+    });
+}
+
+/* shrink_to_fit()
+*
+*  shrinks every shard to the smallest tables that hold its records
+*/
+template <typename Key, typename Value, std::size_t ShardCount, typename Table>
+void ShardedCuckooHash<Key, Value, ShardCount, Table>::shrink_to_fit()
+{
+    forEachShard([&](std::size_t s)
+    {
+        std::lock_guard<std::mutex> lock(shards[s].mutex);
+        shards[s].table.shrink_to_fit();
+    });
+}
+
+/* set_incremental_resize()
+*
+*  chooses incremental or stop-the-world growth for every shard. Incremental growth also bounds how long
+*  one operation holds its shard's lock.
+*/
+template <typename Key, typename Value, std::size_t ShardCount, typename Table>
+void ShardedCuckooHash<Key, Value, ShardCount, Table>::set_incremental_resize(bool enabled)
+{
+    for (std::size_t s = 0; s < ShardCount; ++s)
+    {
+        std::lock_guard<std::mutex> lock(shards[s].mutex);
+        shards[s].table.set_incremental_resize(enabled);
+    }
+}
+
+/* set_filter()
+*
+*  keeps (or drops) a cuckoo::CuckooFilter in every shard
+*/
+template <typename Key, typename Value, std::size_t ShardCount, typename Table>
+void ShardedCuckooHash<Key, Value, ShardCount, Table>::set_filter(bool enabled)
+{
+    forEachShard([&](std::size_t s)
+    {
+        std::lock_guard<std::mutex> lock(shards[s].mutex);
+        shards[s].table.set_filter(enabled);
+    });
+}
+
+/* stats()
+*
+*  every shard's stats(), taken under its lock, summed (and the loads averaged)
+*/
+template <typename Key, typename Value, std::size_t ShardCount, typename Table>
+typename ShardedCuckooHash<Key, Value, ShardCount, Table>::Stats ShardedCuckooHash<Key, Value, ShardCount, Table>::stats() const
+{
+    Stats total = Stats();
+    total.smallestShard = static_cast<std::size_t>(-1);
+
+    for (std::size_t s = 0; s < ShardCount; ++s)
+    {
+        typename Table::Stats shard;
+        {
+            std::lock_guard<std::mutex> lock(shards[s].mutex);
+            shard = shards[s].table.stats();
+        }
+
+        total.records += shard.records;
+        total.smallestShard = std::min(total.smallestShard, shard.records);
+        total.largestShard = std::max(total.largestShard, shard.records);
+        total.loadFactor += shard.loadFactor / ShardCount;
+        total.largestLoad = std::max(total.largestLoad, shard.loadFactor);
+        total.stashed += shard.stashed;
+        total.resizingShards += shard.resizing ? 1 : 0;
+        total.filterBytes += shard.filterBytes;
+        total.instrumented = shard.instrumented;
+        cuckoo::addMetrics(total.metrics, shard.metrics);
+    }
+
+    return total;
+}
+
+/* forEachShard()
+*
+*  runs work(s) for every shard s, with the shards dealt out to min(thread_count(), ShardCount) threads
+*  in turn, so each thread works on shards no other thread touches
+*/
+template <typename Key, typename Value, std::size_t ShardCount, typename Table>
+template <typename Function>
+void ShardedCuckooHash<Key, Value, ShardCount, Table>::forEachShard(Function work) const
+{
+    std::size_t parts = std::min(threadCount, ShardCount);
+    cuckoo::runParallel(parts, [&](std::size_t part)
+    {
+        for (std::size_t s = part; s < ShardCount; s += parts)
+        {
+            work(s);
+        }
+    });
+}
+
+/* partsFor()
+*
+*  one part below PARALLEL_MIN_RECORDS items, and thread_count() parts from there on
+*/
+template <typename Key, typename Value, std::size_t ShardCount, typename Table>
+std::size_t ShardedCuckooHash<Key, Value, ShardCount, Table>::partsFor(std::size_t count) const
+{
+    return count < cuckoo::PARALLEL_MIN_RECORDS ? 1 : threadCount;
+}
+
+#endif // SHARDEDCUCKOOHASH_HPP_INCLUDED
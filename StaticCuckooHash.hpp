@@ -0,0 +1,323 @@
+/*
+    Data Structures
+    Project Hash: Cuckoo Hashing
+    Author: Anthony Lupica <arl127@uakron.edu> 2022
+
+    Header file for StaticCuckooHash, a fixed-capacity cuckoo hash table for key sets known in advance,
+    which can be built at compile time.
+
+    The table is built once, by its constructor, from arrays of keys and values (or of key - value
+    pairs), and never changes afterwards. Its records sit in two std::arrays of slots inside the object,
+    one record per slot, sized for Capacity records at STATIC_MAX_LOAD: nothing is allocated, so with
+    literal Key and Value types (integers, std::string_view) the constructor runs at compile time and the
+    table costs nothing at run time.
+
+    Ex.] Birth Year, at compile time
+    static constexpr std::string_view names[] = { "Brad Pitt", "Zendaya" };
+    static constexpr int years[] = { 1963, 1996 };
+    constexpr StaticCuckooHash<std::string_view, int, 2> birthYears(names, years, 2);
+    static_assert(*birthYears.search("Zendaya") == 1996);
+
+    Every key lives in one of its two candidate slots, the table 1 slot of the low half of its hash code
+    or the table 2 slot of the high half, as in CuckooHash, and there is no stash. The constructor
+    places the records with bounded cuckoo displacements, and when a record cannot be placed it starts
+    over with the next seed for the Hasher, up to STATIC_MAX_SEEDS seeds, so the layout it settles on
+    is a perfect two-probe one. A lookup hashes once, compares the key with both candidate slots without
+    branching on the first, and selects the match.
+
+    Displacements only change which of its two slots a key ends up in, never how many a lookup reads,
+    so a layout built with evictions answers exactly like one built without. The build does not insist
+    on a seed that needs none: at STATIC_MAX_LOAD, a seed places every record without an eviction for
+    about a third of 30-record key sets, one in forty at 100 records, and practically never from a few
+    hundred on, so such a build would fail for all but the smallest tables. Allowing up to
+    STATIC_MAX_KICKS evictions per record, the first seed almost always succeeds.
+
+    A build that fails (more records than Capacity, or no seed placing them all) is an error: at compile
+    time it stops compilation, at run time it writes to std::cerr and leaves built() false and the table
+    empty. As with CuckooHash::build(), a key repeated in the input keeps its first value.
+
+    At compile time the build is limited by the compiler's constexpr step limits, which keep tables to a
+    few thousand records; larger key sets can be built at startup, into a static object.
+*/
+
+#ifndef STATICCUCKOOHASH_HPP_INCLUDED
+#define STATICCUCKOOHASH_HPP_INCLUDED
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <utility>
+
+#include "CuckooHasher.hpp"
+
+namespace cuckoo
+{
+    // the load a StaticCuckooHash of Capacity records runs at. Below one half, random two-choice placement
+    // almost always succeeds
+    constexpr double STATIC_MAX_LOAD = 0.4;
+
+    // seeds a StaticCuckooHash tries before its build fails
+    constexpr std::size_t STATIC_MAX_SEEDS = 64;
+
+    // displacements one record may cause before a StaticCuckooHash gives up on a seed
+    constexpr std::size_t STATIC_MAX_KICKS = 128;
+
+    // how the seeds a StaticCuckooHash tries step apart
+    constexpr std::uint64_t STATIC_SEED_STEP = 0x9e3779b97f4a7c15ULL;
+}
+
+template <typename Key, typename Value, std::size_t Capacity, typename Hasher = cuckoo::Hash<Key>, typename KeyEqual = cuckoo::Equal<Key>>
+class StaticCuckooHash
+{
+    static_assert(Capacity >= 1, "Capacity must be at least 1");
+
+    public:
+
+        // buckets (one slot each) of each of the two tables
+        static constexpr std::size_t BUCKETS = static_cast<std::size_t>(Capacity / (2 * cuckoo::STATIC_MAX_LOAD)) + 1;
+
+    private:
+
+        // private data members
+        std::array<Key, 2 * BUCKETS> keys;            // table 1 in [0, BUCKETS), table 2 in [BUCKETS, 2 * BUCKETS)
+        std::array<Value, 2 * BUCKETS> values;        // the value of the key in the same slot
+        std::array<bool, 2 * BUCKETS> occupied;       // true for the slots holding a record
+        std::size_t records;                          // records placed
+        std::uint64_t hashSeed;                       // the seed the layout was built with
+        bool complete;                                // true once every record was placed
+
+        // private methods
+        constexpr std::uint64_t hashOf(const Key &key, std::uint64_t seed) const; // the 64-bit hash code of key under seed
+        static constexpr std::size_t firstSlot(std::uint64_t hashCode)          // the table 1 slot of a hash code
+        { return static_cast<std::size_t>(cuckoo::fastRange(static_cast<std::uint32_t>(hashCode), static_cast<std::uint32_t>(BUCKETS))); }
+        static constexpr std::size_t secondSlot(std::uint64_t hashCode)         // the table 2 slot of a hash code
+        { return BUCKETS + static_cast<std::size_t>(cuckoo::fastRange(static_cast<std::uint32_t>(hashCode >> 32), static_cast<std::uint32_t>(BUCKETS))); }
+        constexpr bool place(const Key &key, const Value &value);              // adds a record under hashSeed, false if it could not be placed
+        template <typename KeyAt, typename ValueAt>
+        constexpr void build(std::size_t count, KeyAt keyAt, ValueAt valueAt); // tries seeds until all count records are placed
+        constexpr void clear();                                                 // empties every slot
+
+    public:
+
+        using key_type = Key;      // the Key template parameter
+        using mapped_type = Value; // the Value template parameter
+
+        // ctors
+        constexpr StaticCuckooHash(const Key *keyList, const Value *valueList, std::size_t count); // table of keyList[i] - valueList[i] for i in [0, count)
+        template <std::size_t N>
+        constexpr StaticCuckooHash(const std::pair<Key, Value> (&recordList)[N]);                 // table of an array of key - value pairs
+
+        // public methods
+        constexpr const Value *search(const Key &key) const;                   // search the hash table for a record (nullptr if absent)
+        constexpr bool contains(const Key &key) const                         // find if the hash table contains a record
+        { return search(key) != nullptr; }
+        constexpr std::size_t size() const                                     // getter for the number of records
+        { return records; }
+        static constexpr std::size_t capacity()                                // getter for Capacity
+        { return Capacity; }
+        constexpr bool built() const                                           // true if every record was placed
+        { return complete; }
+        constexpr std::uint64_t seed() const                                   // getter for the seed the layout was built with
+        { return hashSeed; }
+        template <typename Function>
+        void for_each(Function visit) const;                                    // call visit(key, value) for every record, in no particular order
+        void display() const;                                                   // display the hash table (requires operator<< for Key and Value)
+};
+
+/* Constructor
+*
+*  builds the table from the parallel arrays keyList and valueList of count records
+*/
+template <typename Key, typename Value, std::size_t Capacity, typename Hasher, typename KeyEqual>
+constexpr StaticCuckooHash<Key, Value, Capacity, Hasher, KeyEqual>::StaticCuckooHash(const Key *keyList, const Value *valueList, std::size_t count)
+    : keys{}, values{}, occupied{}, records(0), hashSeed(cuckoo::DEFAULT_SEED), complete(false)
+{
+    build(count, [keyList](std::size_t i) -> const Key & { return keyList[i]; }, [valueList](std::size_t i) -> const Value & { return valueList[i]; });
+}
+
+/* Constructor
+*
+*  builds the table from an array of N key - value pairs (N may not exceed Capacity)
+*/
+template <typename Key, typename Value, std::size_t Capacity, typename Hasher, typename KeyEqual>
+template <std::size_t N>
+constexpr StaticCuckooHash<Key, Value, Capacity, Hasher, KeyEqual>::StaticCuckooHash(const std::pair<Key, Value> (&recordList)[N])
+    : keys{}, values{}, occupied{}, records(0), hashSeed(cuckoo::DEFAULT_SEED), complete(false)
+{
+    static_assert(N <= Capacity, "more records than Capacity");
+
+    build(N, [&recordList](std::size_t i) -> const Key & { return recordList[i].first; }, [&recordList](std::size_t i) -> const Value & { return recordList[i].second; });
+}
+
+/* search()
+*
+*  hashes the key once and compares it with the records of both of its slots. Both comparisons are made,
+*  and the slot is picked from their results, so the only branch on the data is the final one.
+*/
+template <typename Key, typename Value, std::size_t Capacity, typename Hasher, typename KeyEqual>
+constexpr const Value *StaticCuckooHash<Key, Value, Capacity, Hasher, KeyEqual>::search(const Key &key) const
+{
+    std::uint64_t hashCode = hashOf(key, hashSeed);
+    std::size_t first = firstSlot(hashCode);
+    std::size_t second = secondSlot(hashCode);
+
+    bool inFirst = occupied[first] & KeyEqual()(keys[first], key);
+    bool inSecond = occupied[second] & KeyEqual()(keys[second], key);
+    std::size_t slot = inFirst ? first : second;
+
+    return (inFirst | inSecond) ? &values[slot] : nullptr;
+}
+
+/* for_each()
+*
+*  calls visit(key, value) for every record, those of table 1 first
+*/
+template <typename Key, typename Value, std::size_t Capacity, typename Hasher, typename KeyEqual>
+template <typename Function>
+void StaticCuckooHash<Key, Value, Capacity, Hasher, KeyEqual>::for_each(Function visit) const
+{
+    for (std::size_t slot = 0; slot < 2 * BUCKETS; ++slot)
+    {
+        if (occupied[slot])
+        {
+            visit(keys[slot], values[slot]);
+        }
+    }
+}
+
+/* display()
+*
+*  prints every record as "key : value"
+*/
+template <typename Key, typename Value, std::size_t Capacity, typename Hasher, typename KeyEqual>
+void StaticCuckooHash<Key, Value, Capacity, Hasher, KeyEqual>::display() const
+{
+    for_each([](const Key &key, const Value &value)
+    {
+        std::cout << key << " : " << value << "\n";
+    });
+    // output a new line
+    std::cout << "\n";
+}
+
+/* hashOf()
+*
+*  the Hasher's code for key with seed, finalized with mixInt() for a Hasher that does not avalanche. A
+*  Hasher without a seed is mixed with the seed instead, so every seed still gives another layout.
+*/
+template <typename Key, typename Value, std::size_t Capacity, typename Hasher, typename KeyEqual>
+constexpr std::uint64_t StaticCuckooHash<Key, Value, Capacity, Hasher, KeyEqual>::hashOf(const Key &key, std::uint64_t seed) const
+{
+    if constexpr (cuckoo::has_seed<Hasher>::value && cuckoo::is_avalanching<Hasher>::value)
+    {
+        return static_cast<std::uint64_t>(Hasher(seed)(key));
+    }
+    else
+    {
+        return cuckoo::mixInt(static_cast<std::uint64_t>(Hasher()(key)), seed);
+    }
+}
+
+/* place()
+*
+*  puts the record into a free one of its two slots. With both taken, it takes the table 1 slot and
+*  moves the record it evicts to that record's other slot, and so on, for at most STATIC_MAX_KICKS
+*  evictions. A key already present keeps its value and counts as placed. Returns false if the last
+*  evicted record was left without a slot, which leaves the table unusable until clear().
+*/
+template <typename Key, typename Value, std::size_t Capacity, typename Hasher, typename KeyEqual>
+constexpr bool StaticCuckooHash<Key, Value, Capacity, Hasher, KeyEqual>::place(const Key &key, const Value &value)
+{
+    std::uint64_t hashCode = hashOf(key, hashSeed);
+    std::size_t first = firstSlot(hashCode);
+    std::size_t second = secondSlot(hashCode);
+    if ((occupied[first] && KeyEqual()(keys[first], key)) || (occupied[second] && KeyEqual()(keys[second], key)))
+    {
+        return true;
+    }
+
+    Key movingKey = key;
+    Value movingValue = value;
+    std::size_t slot = !occupied[first] || occupied[second] ? first : second;
+    for (std::size_t kicks = 0; kicks <= cuckoo::STATIC_MAX_KICKS; ++kicks)
+    {
+        if (!occupied[slot])
+        {
+            keys[slot] = std::move(movingKey);
+            values[slot] = std::move(movingValue);
+            occupied[slot] = true;
+            ++records;
+
+            return true;
+        }
+
+        // take the slot, and carry its record on to its other slot (the std::swap of C++17 is not constexpr)
+        Key evictedKey = std::move(keys[slot]);
+        Value evictedValue = std::move(values[slot]);
+        keys[slot] = std::move(movingKey);
+        values[slot] = std::move(movingValue);
+        movingKey = std::move(evictedKey);
+        movingValue = std::move(evictedValue);
+
+        std::uint64_t movingCode = hashOf(movingKey, hashSeed);
+        slot = slot == firstSlot(movingCode) ? secondSlot(movingCode) : firstSlot(movingCode);
+    }
+
+    return false;
+}
+
+/* build()
+*
+*  places the count records keyAt(i) - valueAt(i), starting over with the next seed whenever one cannot be
+*  placed. After STATIC_MAX_SEEDS seeds, or with more than Capacity records, the table is left empty
+*  and the failure reported.
+*/
+template <typename Key, typename Value, std::size_t Capacity, typename Hasher, typename KeyEqual>
+template <typename KeyAt, typename ValueAt>
+constexpr void StaticCuckooHash<Key, Value, Capacity, Hasher, KeyEqual>::build(std::size_t count, KeyAt keyAt, ValueAt valueAt)
+{
+    if (count > Capacity)
+    {
+        std::cerr << "StaticCuckooHash: " << count << " records exceed the capacity of " << Capacity << "\n";
+        return;
+    }
+
+    for (std::size_t attempt = 0; attempt < cuckoo::STATIC_MAX_SEEDS; ++attempt)
+    {
+        clear();
+        hashSeed = cuckoo::DEFAULT_SEED + attempt * cuckoo::STATIC_SEED_STEP;
+
+        std::size_t i = 0;
+        while (i < count && place(keyAt(i), valueAt(i)))
+        {
+            ++i;
+        }
+        if (i == count)
+        {
+            complete = true;
+            return;
+        }
+    }
+
+    clear();
+    std::cerr << "StaticCuckooHash: no seed placed all " << count << " records\n";
+}
+
+/* clear()
+*
+*  empties every slot
+*/
+template <typename Key, typename Value, std::size_t Capacity, typename Hasher, typename KeyEqual>
+constexpr void StaticCuckooHash<Key, Value, Capacity, Hasher, KeyEqual>::clear()
+{
+    for (std::size_t slot = 0; slot < 2 * BUCKETS; ++slot)
+    {
+        keys[slot] = Key();
+        values[slot] = Value();
+        occupied[slot] = false;
+    }
+    records = 0;
+}
+
+#endif // STATICCUCKOOHASH_HPP_INCLUDED
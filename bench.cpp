@@ -0,0 +1,438 @@
+/*
+    Data Structures
+    Project Hash: Cuckoo Hashing
+    Author: Anthony Lupica <arl127@uakron.edu> 2022
+
+    Micro-benchmarks of the CuckooHash class template, with std::unordered_map as the baseline.
+
+    Every combination of
+        key size       8 bytes (std::uint64_t), and 16, 64 and 256 byte std::strings
+        table size     records filling about half of L1, half of L2, half of the LLC, and 10 times the LLC
+        key access     uniform, or Zipfian (s = 0.99, hot keys scattered over the table)
+    is measured for
+        insert         every record into an empty table
+        hit / miss     lookups of stored / never stored keys
+        contains       contains() of never stored keys, the miss-heavy case a compact tag array is for
+        hit / miss batch   the hit and miss lookups BATCH_OPS at a time through search_batch() (one find()
+                       after another for std::unordered_map)
+        mixed 95/5     lookups of stored keys, with 5% of the operations inserting or removing another key
+        mixed 50/50    the same with half of the operations writing
+        remove         every record, leaving the table empty
+    on CuckooHash with one and with four slots per bucket (the latter also in the SoA layout, see
+    cuckoo::Layout, and over cuckoo::HugePageAllocator),
+    and each line reports the mean ns/op, the 50th, 90th and 99th percentiles, and the throughput.
+
+    Operations are timed in batches of BATCH_OPS (a clock read costs about as much as a lookup), so
+    the percentiles are those of a batch's ns/op. Keys, access sequences and table contents come from
+    fixed seeds and are generated before the clock starts, so two runs on a machine measure the same work.
+
+    Cache sizes are read from the system where it reports them. Usage:
+        bench [--quick] [--llc BYTES]
+    --quick skips the 10 x LLC tables (which take gigabytes of memory for short keys), and --llc overrides
+    the detected LLC size.
+*/
+
+#include "CuckooHash.hpp"
+#include "HugePageAllocator.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+// operations timed together
+const std::size_t BATCH_OPS = 16;
+
+// fewest and most operations of a lookup or mixed measurement (a table's record count lies in between)
+const std::size_t MIN_OPS = 1 << 18;
+const std::size_t MAX_OPS = 1 << 21;
+
+// skew of the Zipfian access distribution (YCSB's default)
+const double ZIPF_SKEW = 0.99;
+
+/* cacheBytes()
+*
+*  size of the data cache at level (1, 2 or 3) as the system reports it, or fallback
+*/
+std::size_t cacheBytes(int level, std::size_t fallback)
+{
+    long bytes = 0;
+#if defined(_SC_LEVEL1_DCACHE_SIZE) && defined(_SC_LEVEL2_CACHE_SIZE) && defined(_SC_LEVEL3_CACHE_SIZE)
+    bytes = sysconf(level == 1 ? _SC_LEVEL1_DCACHE_SIZE : (level == 2 ? _SC_LEVEL2_CACHE_SIZE : _SC_LEVEL3_CACHE_SIZE));
+#else
+    (void)level;
+#endif
+
+    return bytes > 0 ? static_cast<std::size_t>(bytes) : fallback;
+}
+
+/* Zipf
+*
+*  draws ranks 1 to n with probability proportional to 1 / rank^s in constant time and memory,
+*  by rejection-inversion (Hoermann and Derflinger, 1996)
+*/
+class Zipf
+{
+    private:
+
+        double s;
+        double n;
+        double hIntegralX1;
+        double hIntegralN;
+        double threshold;
+
+        static double helper1(double x) // log1p(x) / x, accurate near 0
+        { return std::fabs(x) > 1e-8 ? std::log1p(x) / x : 1 - x * (0.5 - x * (1.0 / 3 - 0.25 * x)); }
+        static double helper2(double x) // expm1(x) / x, accurate near 0
+        { return std::fabs(x) > 1e-8 ? std::expm1(x) / x : 1 + x * 0.5 * (1 + x / 3 * (1 + 0.25 * x)); }
+        double h(double x) const
+        { return std::exp(-s * std::log(x)); }
+        double hIntegral(double x) const
+        { double logX = std::log(x); return helper2((1 - s) * logX) * logX; }
+        double hIntegralInverse(double x) const
+        { double t = std::max(x * (1 - s), -1.0); return std::exp(helper1(t) * x); }
+
+    public:
+
+        Zipf(std::size_t count, double skew)
+            : s(skew), n(static_cast<double>(count)), hIntegralX1(hIntegral(1.5) - 1), hIntegralN(hIntegral(n + 0.5)),
+              threshold(2 - hIntegralInverse(hIntegral(2.5) - h(2)))
+        {}
+
+        std::size_t operator()(std::mt19937_64 &random) const
+        {
+            for (;;)
+            {
+                double u = hIntegralN + static_cast<double>(random() >> 11) * 0x1p-53 * (hIntegralX1 - hIntegralN);
+                double x = hIntegralInverse(u);
+                double k = std::min(std::max(std::floor(x + 0.5), 1.0), n);
+                if (k - x <= threshold || u >= hIntegral(k + 0.5) - h(k))
+                {
+                    return static_cast<std::size_t>(k);
+                }
+            }
+        }
+};
+
+/* makeKey()
+*
+*  the distinct key number id, for an 8-byte integer key or a string of length bytes. A string starts with
+*  the id's bytes and is filled up with random bytes, as a real key's would differ all over
+*/
+void makeKey(std::uint64_t id, std::size_t, std::mt19937_64 &, std::uint64_t &key)
+{
+    key = id * 0x9E3779B97F4A7C15ULL; // odd multiplier, so distinct ids stay distinct
+}
+
+void makeKey(std::uint64_t id, std::size_t length, std::mt19937_64 &random, std::string &key)
+{
+    key.resize(length);
+    for (std::size_t i = 0; i < length; i += 8)
+    {
+        std::uint64_t word = i == 0 ? id : random();
+        std::memcpy(&key[i], &word, std::min<std::size_t>(8, length - i));
+    }
+}
+
+// the same few operations on either kind of table
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+void insertKey(CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator> &table, const Key &key, int value)
+{ table.insert(key, value); }
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+bool findKey(const CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator> &table, const Key &key)
+{ return table.search(key) != nullptr; }
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+bool containsKey(const CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator> &table, const Key &key)
+{ return table.contains(key); }
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+void removeKey(CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator> &table, const Key &key)
+{ table.remove(key); }
+
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, std::size_t SlotsPerBucket, cuckoo::Layout SlotLayout, std::size_t TableCount, typename Allocator>
+std::size_t findKeys(const CuckooHash<Key, Value, Hasher, KeyEqual, SlotsPerBucket, SlotLayout, TableCount, Allocator> &table, const Key *keys, std::size_t count)
+{ const Value *values[BATCH_OPS]; return table.search_batch(keys, count, values); }
+
+template <typename Key>
+void insertKey(std::unordered_map<Key, int> &table, const Key &key, int value)
+{ table.emplace(key, value); }
+template <typename Key>
+bool findKey(const std::unordered_map<Key, int> &table, const Key &key)
+{ return table.find(key) != table.end(); }
+template <typename Key>
+bool containsKey(const std::unordered_map<Key, int> &table, const Key &key)
+{ return table.count(key) != 0; }
+template <typename Key>
+std::size_t findKeys(const std::unordered_map<Key, int> &table, const Key *keys, std::size_t count)
+{ std::size_t found = 0; for (std::size_t i = 0; i < count; ++i) { found += table.find(keys[i]) != table.end(); } return found; }
+template <typename Key>
+void removeKey(std::unordered_map<Key, int> &table, const Key &key)
+{ table.erase(key); }
+
+// one operation of a lookup or mixed measurement
+struct Op
+{
+    std::uint32_t index; // into the stored keys (a lookup) or the spare keys (a write)
+    std::uint8_t kind;   // LOOKUP, INSERT or REMOVE
+};
+enum { LOOKUP, INSERT, REMOVE };
+
+// what a measurement runs on: the keys of one key size and table size, and the access sequences over them
+template <typename Key>
+struct Workload
+{
+    const char *keyName;
+    std::vector<Key> keys;   // stored by every table
+    std::vector<Key> spares; // never stored, except briefly by the mixed writes
+    std::vector<Op> hit[2];  // per distribution (uniform, Zipfian): lookups of stored keys
+    std::vector<Op> miss[2]; //   lookups of spare keys
+    std::vector<Op> mixed5[2];
+    std::vector<Op> mixed50[2];
+};
+
+/* report()
+*
+*  prints one measurement from its per-batch ns/op samples
+*/
+void report(const char *table, const char *op, const char *keyName, const char *dist, std::size_t records, std::vector<double> &samples, double totalNs, std::size_t ops)
+{
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&](double p) { return samples.empty() ? 0.0 : samples[static_cast<std::size_t>(p * (samples.size() - 1))]; };
+
+    std::printf("%-20s %-11s %-8s %-8s %10zu %9.1f %9.1f %9.1f %9.1f %9.2f\n", table, op, keyName, dist, records,
+                totalNs / ops, percentile(0.5), percentile(0.9), percentile(0.99), ops / totalNs * 1e3);
+}
+
+// keeps lookup results alive, so the compiler cannot drop the lookups
+volatile std::size_t sink = 0;
+
+/* run()
+*
+*  runs every measurement on one kind of table, and prints its lines
+*/
+template <typename Table, typename Key>
+void run(const char *tableName, const Workload<Key> &work)
+{
+    Table table;
+    std::vector<double> samples;
+    samples.reserve(MAX_OPS / BATCH_OPS + 1);
+    std::size_t records = work.keys.size();
+    std::size_t found = 0;
+
+    // times ops in batches: step(i) performs operation i
+    auto measure = [&](const char *op, const char *dist, std::size_t ops, auto step)
+    {
+        samples.clear();
+        double totalNs = 0;
+        for (std::size_t first = 0; first < ops; first += BATCH_OPS)
+        {
+            std::size_t last = std::min(ops, first + BATCH_OPS);
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (std::size_t i = first; i < last; ++i)
+            {
+                step(i);
+            }
+            double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            samples.push_back(ns / (last - first));
+            totalNs += ns;
+        }
+        report(tableName, op, work.keyName, dist, records, samples, totalNs, ops);
+    };
+
+    measure("insert", "-", records, [&](std::size_t i) { insertKey(table, work.keys[i], static_cast<int>(i)); });
+
+    const char *DIST_NAMES[2] = { "uniform", "zipf" };
+    for (int dist = 0; dist < 2; ++dist)
+    {
+        const std::vector<Op> &hit = work.hit[dist];
+        const std::vector<Op> &miss = work.miss[dist];
+        measure("hit", DIST_NAMES[dist], hit.size(), [&](std::size_t i) { found += findKey(table, work.keys[hit[i].index]); });
+        measure("miss", DIST_NAMES[dist], miss.size(), [&](std::size_t i) { found += findKey(table, work.spares[miss[i].index]); });
+        measure("contains", DIST_NAMES[dist], miss.size(), [&](std::size_t i) { found += containsKey(table, work.spares[miss[i].index]); });
+
+        // the same lookups as batches of BATCH_OPS keys, gathered before the clock starts: each timed
+        // batch of measure() is one findKeys() call
+        for (int kind = 0; kind < 2; ++kind)
+        {
+            const std::vector<Op> &ops = kind == 0 ? hit : miss;
+            const std::vector<Key> &source = kind == 0 ? work.keys : work.spares;
+            std::vector<Key> gathered;
+            gathered.reserve(ops.size());
+            for (const Op &op : ops)
+            {
+                gathered.push_back(source[op.index]);
+            }
+            measure(kind == 0 ? "hit batch" : "miss batch", DIST_NAMES[dist], ops.size(), [&](std::size_t i)
+            {
+                if (i % BATCH_OPS == 0)
+                {
+                    found += findKeys(table, &gathered[i], std::min(BATCH_OPS, ops.size() - i));
+                }
+            });
+        }
+
+        const std::vector<Op> *mixes[2] = { &work.mixed5[dist], &work.mixed50[dist] };
+        const char *MIX_NAMES[2] = { "mixed 95/5", "mixed 50/50" };
+        for (int mix = 0; mix < 2; ++mix)
+        {
+            const std::vector<Op> &ops = *mixes[mix];
+            measure(MIX_NAMES[mix], DIST_NAMES[dist], ops.size(), [&](std::size_t i)
+            {
+                const Op &op = ops[i];
+                if (op.kind == LOOKUP)
+                {
+                    found += findKey(table, work.keys[op.index]);
+                }
+                else if (op.kind == INSERT)
+                {
+                    insertKey(table, work.spares[op.index], 0);
+                }
+                else
+                {
+                    removeKey(table, work.spares[op.index]);
+                }
+            });
+        }
+    }
+
+    measure("remove", "-", records, [&](std::size_t i) { removeKey(table, work.keys[i]); });
+
+    sink = sink + found;
+}
+
+/* makeWorkload()
+*
+*  generates the keys and access sequences for records keys of length bytes
+*/
+template <typename Key>
+Workload<Key> makeWorkload(const char *keyName, std::size_t length, std::size_t records)
+{
+    Workload<Key> work;
+    work.keyName = keyName;
+    std::mt19937_64 random(records * 1000 + length);
+
+    std::size_t opCount = std::min(std::max(records, MIN_OPS), MAX_OPS);
+    std::size_t spareCount = std::min(records, opCount);
+    work.keys.resize(records);
+    work.spares.resize(spareCount);
+    for (std::size_t i = 0; i < records; ++i)
+    {
+        makeKey(i, length, random, work.keys[i]);
+    }
+    for (std::size_t i = 0; i < spareCount; ++i)
+    {
+        makeKey(records + i, length, random, work.spares[i]);
+    }
+
+    // a Zipfian rank is scattered over the keys by a multiplicative hash, so the hot keys do not
+    // happen to be the first ones inserted
+    Zipf zipf(records, ZIPF_SKEW);
+    auto draw = [&](int dist, std::size_t count)
+    {
+        std::size_t rank = dist == 0 ? random() % count : zipf(random) - 1;
+
+        return static_cast<std::uint32_t>(dist == 0 ? rank : (rank * 0x9E3779B97F4A7C15ULL) % count);
+    };
+
+    for (int dist = 0; dist < 2; ++dist)
+    {
+        for (std::size_t i = 0; i < opCount; ++i)
+        {
+            work.hit[dist].push_back(Op{ draw(dist, records), LOOKUP });
+            work.miss[dist].push_back(Op{ static_cast<std::uint32_t>(draw(dist, records) % spareCount), LOOKUP });
+        }
+
+        // a write inserts the next spare key, and the write after it removes that key again,
+        // so the table keeps its size throughout
+        std::vector<Op> *mixes[2] = { &work.mixed5[dist], &work.mixed50[dist] };
+        const std::size_t WRITES_PER_100[2] = { 5, 50 };
+        for (int mix = 0; mix < 2; ++mix)
+        {
+            std::size_t writes = 0;
+            for (std::size_t i = 0; i < opCount; ++i)
+            {
+                if (random() % 100 < WRITES_PER_100[mix])
+                {
+                    mixes[mix]->push_back(Op{ static_cast<std::uint32_t>((writes / 2) % spareCount), writes % 2 == 0 ? INSERT : REMOVE });
+                    ++writes;
+                }
+                else
+                {
+                    mixes[mix]->push_back(Op{ draw(dist, records), LOOKUP });
+                }
+            }
+            if (writes % 2 == 1)
+            {
+                mixes[mix]->push_back(Op{ static_cast<std::uint32_t>((writes / 2) % spareCount), REMOVE });
+            }
+        }
+    }
+
+    return work;
+}
+
+/* benchKeys()
+*
+*  runs every table kind over each table size for one key size
+*/
+template <typename Key>
+void benchKeys(const char *keyName, std::size_t length, const std::vector<std::size_t> &workingSets)
+{
+    for (std::size_t bytes : workingSets)
+    {
+        std::size_t records = std::max<std::size_t>(bytes / (length + sizeof(int)), 64);
+        Workload<Key> work = makeWorkload<Key>(keyName, length, records);
+
+        run<CuckooHash<Key, int>>("CuckooHash", work);
+        run<CuckooHash<Key, int, cuckoo::Hash<Key>, cuckoo::Equal<Key>, 4>>("CuckooHash B=4", work);
+        run<CuckooHash<Key, int, cuckoo::Hash<Key>, cuckoo::Equal<Key>, 4, cuckoo::Layout::SoA>>("CuckooHash B=4 SoA", work);
+        run<CuckooHash<Key, int, cuckoo::Hash<Key>, cuckoo::Equal<Key>, 4, cuckoo::Layout::AoS, 2, cuckoo::HugePageAllocator<unsigned char>>>("CuckooHash B=4 huge", work);
+        run<std::unordered_map<Key, int>>("unordered_map", work);
+        std::printf("\n");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    bool quick = false;
+    std::size_t llc = cacheBytes(3, 32 << 20);
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--quick") == 0)
+        {
+            quick = true;
+        }
+        else if (std::strcmp(argv[i], "--llc") == 0 && i + 1 < argc)
+        {
+            llc = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else
+        {
+            std::fprintf(stderr, "usage: %s [--quick] [--llc BYTES]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<std::size_t> workingSets = { cacheBytes(1, 32 << 10) / 2, cacheBytes(2, 1 << 20) / 2, llc / 2 };
+    if (!quick)
+    {
+        workingSets.push_back(llc * 10);
+    }
+
+    std::printf("%-20s %-11s %-8s %-8s %10s %9s %9s %9s %9s %9s\n", "table", "op", "key", "access", "records", "ns/op", "p50", "p90", "p99", "Mops/s");
+    benchKeys<std::uint64_t>("8 B", 8, workingSets);
+    benchKeys<std::string>("16 B", 16, workingSets);
+    benchKeys<std::string>("64 B", 64, workingSets);
+    benchKeys<std::string>("256 B", 256, workingSets);
+
+    return 0;
+}
@@ -5,28 +5,64 @@
 
     Driver file using the CuckooHash class
 
-    Test Cases are used to display the functionality and analyze the performance
-    of a hash table that uses the cuckoo hashing technique.
+    Test Cases are used to display the functionality of a hash table that uses the
+    cuckoo hashing technique, of its thread-safe variant, ConcurrentCuckooHash, and of
+    ArenaCuckooHash, which keeps its string keys in one arena, and of the cuckoo::CuckooFilter a
+    table may keep of its keys.
+    Its performance is measured by the bench target (bench.cpp).
 
     The chosen name - year association is different celebrities and their birth years.
+    A file of further "name,year" lines may be given as the first argument, and is streamed
+    into a table with cuckoo::load_file(). The celebrities are also put into a StaticCuckooHash,
+    which the compiler builds.
 */
 
+#include "ArenaCuckooHash.hpp"
 #include "CuckooHash.hpp"
-#include "Complexity_Timer.hpp"
+#include "CuckooFilter.hpp"
+#include "ConcurrentCuckooHash.hpp"
+#include "CuckooLoader.hpp"
+#include "StaticCuckooHash.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
 #include <iostream>
 #include <cassert>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
 using std::cout;
+using std::string;
 
-int main()
+// a Hasher placing the keys "A", "B" and "C" so that they fit tables of 16 buckets, share one bucket
+// of each table in tables of 20, and fit again in tables of 40 (see cuckoo::hash1() and cuckoo::hash2())
+struct CrowdingHash
+{
+    using is_avalanching = void;
+
+    std::uint64_t operator()(std::string_view key) const
+    {
+        const std::uint64_t NEAR = 225485783;  // 0.0525 of 2^32
+        const std::uint64_t FAR = 343597383;   // 0.08 of 2^32
+
+        std::uint64_t low = key == "A" ? NEAR : FAR;
+        std::uint64_t high = key == "C" ? FAR : NEAR;
+
+        return high << 32 | low;
+    }
+};
+
+int main(int argc, char *argv[])
 {
     //----- Testing Section For Correctness -----//
 
     cout << "\nTESTING FOR CORRECTNESS\n\n";
 
     // create a hash table object, call it hashTest, and initialize with a name and birth year
-    CuckooHash hashTest("Brad Pitt", 1963);
+    CuckooHash<string, int> hashTest("Brad Pitt", 1963);
     
     // insert names and birth years
     hashTest.insert("Natalie Portman", 1981);
@@ -36,12 +72,12 @@ int main()
     hashTest.insert("Betty White", 1922);
 
     // call search() on the inserts and verify with asserts that the years match
-    assert(hashTest.search("Brad Pitt") == 1963 && "An unexpected birth year was found");
-    assert(hashTest.search("Natalie Portman") == 1981 && "An unexpected birth year was found");
-    assert(hashTest.search("Johnny Depp") == 1963 && "An unexpected birth year was found");
-    assert(hashTest.search("Beyonce") == 1981 && "An unexpected birth year was found");
-    assert(hashTest.search("Tom Brady") == 1977 && "An unexpected birth year was found");
-    assert(hashTest.search("Betty White") == 1922 && "An unexpected birth year was found");
+    assert(*hashTest.search("Brad Pitt") == 1963 && "An unexpected birth year was found");
+    assert(*hashTest.search("Natalie Portman") == 1981 && "An unexpected birth year was found");
+    assert(*hashTest.search("Johnny Depp") == 1963 && "An unexpected birth year was found");
+    assert(*hashTest.search("Beyonce") == 1981 && "An unexpected birth year was found");
+    assert(*hashTest.search("Tom Brady") == 1977 && "An unexpected birth year was found");
+    assert(*hashTest.search("Betty White") == 1922 && "An unexpected birth year was found");
     
     // call size() for the number of records in the table and verify with an assert 
     assert(hashTest.size() == 6 && "An unexpected size was returned");
@@ -58,10 +94,10 @@ int main()
 
     // delete a record, test search on that record, verify that size updates, reinsert the same record, test search and size again
     hashTest.remove("Beyonce");
-    assert(hashTest.search("Beyonce") == -1 && "An unexpected birth year was found");
+    assert(hashTest.search("Beyonce") == nullptr && "An unexpected birth year was found");
     assert(hashTest.size() == 7 && "An unexpected size was returned");
     hashTest.insert("Beyonce", 1981);
-    assert(hashTest.search("Beyonce") == 1981 && "An unexpected birth year was found");
+    assert(*hashTest.search("Beyonce") == 1981 && "An unexpected birth year was found");
     assert(hashTest.size() == 8 && "An unexpected size was returned");
 
     // test contains()
@@ -69,6 +105,147 @@ int main()
     assert(hashTest.contains("Natalie Portman") == 1 && "A record that should exist was not found");
     assert(hashTest.contains("Tom Brady") == 1 && "A record that should exist was not found");
 
+    // lookups by std::string_view search the std::string keys without copying them
+    assert(*hashTest.search(std::string_view("Tom Brady")) == 1977 && "An unexpected birth year was found");
+
+    // a ConcurrentCuckooHash shared by several threads, each inserting, searching and removing keys of its own
+    // (interleaved with the others' keys, so they contend for the same buckets) while the tables grow
+    ConcurrentCuckooHash<std::uint64_t, int> concurrentTest;
+    const int NUM_THREADS = 4;
+    const int NUM_PER_THREAD = 5000;
+    std::atomic<int> inserted(0), duplicates(0), found(0), removed(0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < NUM_THREADS; ++t)
+    {
+        workers.emplace_back([&, t]
+        {
+            for (int i = 0; i < NUM_PER_THREAD; ++i)
+            {
+                inserted += concurrentTest.insert(std::uint64_t(i) * NUM_THREADS + t, i) == cuckoo::Status::Inserted;
+            }
+            duplicates += concurrentTest.insert(std::uint64_t(t), -1) == cuckoo::Status::Exists;
+            for (int i = 0; i < NUM_PER_THREAD; ++i)
+            {
+                int value = -1;
+                found += concurrentTest.search(std::uint64_t(i) * NUM_THREADS + t, value) && value == i;
+                removed += i % 2 == 1 && concurrentTest.remove(std::uint64_t(i) * NUM_THREADS + t);
+            }
+        });
+    }
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+    assert(inserted == NUM_THREADS * NUM_PER_THREAD && duplicates == NUM_THREADS && "A concurrent insert returned an unexpected status");
+    assert(found == NUM_THREADS * NUM_PER_THREAD && "A concurrent search missed a record");
+    assert(removed == NUM_THREADS * NUM_PER_THREAD / 2 && concurrentTest.size() == std::size_t(NUM_THREADS * NUM_PER_THREAD / 2) && "An unexpected size was returned");
+    for (std::uint64_t key = 0; key < std::uint64_t(NUM_THREADS * NUM_PER_THREAD); ++key)
+    {
+        assert(concurrentTest.contains(key) == (key / NUM_THREADS % 2 == 0) && "A removed record was found, or a kept one was not");
+    }
+
+    // an ArenaCuckooHash keeps the key bytes in one arena. Removing most of the records compacts it,
+    // after which the remaining keys must still be found, and a key too long for a KeyRef is refused
+    ArenaCuckooHash<int> arenaTest;
+    const int NUM_ARENA = 2000;
+    const string ARENA_PREFIX(60, '#');
+    for (int i = 0; i < NUM_ARENA; ++i)
+    {
+        arenaTest.insert(ARENA_PREFIX + std::to_string(i), i);
+    }
+    arenaTest.insert(ARENA_PREFIX + "0", -1);
+    assert(arenaTest.size() == NUM_ARENA && *arenaTest.search(ARENA_PREFIX + "0") == 0 && "An unexpected size was returned");
+    [[maybe_unused]] std::size_t arenaBytes = arenaTest.arena_bytes();
+    for (int i = 0; i < NUM_ARENA; ++i)
+    {
+        if (i % 4 != 0)
+        {
+            arenaTest.remove(ARENA_PREFIX + std::to_string(i));
+        }
+    }
+    assert(arenaTest.size() == NUM_ARENA / 4 && arenaTest.arena_bytes() < arenaBytes / 2 && "The key arena was not compacted");
+    for (int i = 0; i < NUM_ARENA; ++i)
+    {
+        [[maybe_unused]] const int *year = arenaTest.search(ARENA_PREFIX + std::to_string(i));
+        assert((i % 4 == 0 ? year != nullptr && *year == i : year == nullptr) && "A record was lost, or a removed one found, by the compaction");
+    }
+    arenaTest.insert(string(std::size_t(1) << cuckoo::ARENA_LENGTH_BITS, 'x'), 0);
+    assert(arenaTest.size() == NUM_ARENA / 4 && !arenaTest.contains(string(std::size_t(1) << cuckoo::ARENA_LENGTH_BITS, 'x')) && "A key longer than a KeyRef can hold was stored");
+
+    // growing an arena table to 20 buckets, where its three keys share two slots, fails part way:
+    // the values moved so far must go back to their slots before the tables grow to 40 buckets instead
+    ArenaCuckooHash<string, CrowdingHash, 1> crowdedTest;
+    crowdedTest.insert("A", "first");
+    crowdedTest.insert("B", "second");
+    crowdedTest.insert("C", "third");
+    crowdedTest.reserve(19);
+    assert(crowdedTest.capacity() == 40 && crowdedTest.size() == 3 && "The tables did not grow past the size the keys do not fit");
+    assert(*crowdedTest.search("A") == "first" && *crowdedTest.search("B") == "second" && *crowdedTest.search("C") == "third"
+        && "A record was lost, or its value, by the failed growth");
+
+    // a snapshot of the arena table, mapped back in: lookups are served from the mapping, and the first insert copies it
+    const char *SNAPSHOT_PATH = "arenaTest.snapshot";
+    [[maybe_unused]] bool saved = arenaTest.save(SNAPSHOT_PATH);
+    assert(saved && "The snapshot could not be written");
+    ArenaCuckooHash<int> arenaMapped;
+    [[maybe_unused]] bool opened = arenaMapped.open_mmap(SNAPSHOT_PATH);
+    assert(opened && arenaMapped.mapped() && arenaMapped.size() == arenaTest.size() && "The snapshot could not be mapped");
+    [[maybe_unused]] const ArenaCuckooHash<int> &arenaView = arenaMapped;
+    for (int i = 0; i < NUM_ARENA; i += 4)
+    {
+        assert(*arenaView.search(ARENA_PREFIX + std::to_string(i)) == i && "An unexpected value was found in the snapshot");
+    }
+    assert(!arenaView.contains(ARENA_PREFIX + "1") && arenaMapped.mapped() && "A lookup changed the mapped snapshot");
+    arenaMapped.insert(ARENA_PREFIX + "1", 1);
+    assert(!arenaMapped.mapped() && *arenaMapped.search(ARENA_PREFIX + "1") == 1 && *arenaMapped.search(ARENA_PREFIX + "4") == 4 && "The insert did not detach the table from its snapshot");
+    std::remove(SNAPSHOT_PATH);
+
+    // a CuckooFilter never misses a key it holds: not once it is full and its stash has run over, nor after removes
+    cuckoo::CuckooFilter<std::uint64_t> filterTest(1000);
+    std::uint64_t numFiltered = 0;
+    while (filterTest.insert(numFiltered))
+    {
+        ++numFiltered;
+    }
+    assert(filterTest.size() == numFiltered && numFiltered >= 1000 && "The filter refused a key before it was full");
+    for (std::uint64_t key = 0; key < numFiltered; ++key)
+    {
+        assert(filterTest.contains(key) && "The full filter missed a key it holds");
+    }
+    for (std::uint64_t key = 1; key < numFiltered; key += 2)
+    {
+        [[maybe_unused]] bool removedKey = filterTest.remove(key);
+        assert(removedKey && "The filter did not find a key to remove");
+    }
+    for (std::uint64_t key = 0; key < numFiltered; key += 2)
+    {
+        assert(filterTest.contains(key) && "The filter missed a key after removes");
+    }
+
+    // a CuckooHash keeping a filter (built from the records already stored, and kept through growth and removes)
+    // finds exactly the records it holds
+    CuckooHash<std::uint64_t, int> filteredTest;
+    const int NUM_FILTERED = 5000;
+    for (int i = 0; i < NUM_FILTERED / 5; ++i)
+    {
+        filteredTest.insert(i, i);
+    }
+    filteredTest.set_filter(true);
+    for (int i = NUM_FILTERED / 5; i < NUM_FILTERED; ++i)
+    {
+        filteredTest.insert(i, i);
+    }
+    for (int i = 0; i < NUM_FILTERED; i += 3)
+    {
+        filteredTest.remove(i);
+    }
+    assert(filteredTest.filtered() && filteredTest.size() == std::size_t(NUM_FILTERED - (NUM_FILTERED + 2) / 3) && "An unexpected size was returned");
+    for (int i = 0; i < 2 * NUM_FILTERED; ++i)
+    {
+        [[maybe_unused]] const int *value = filteredTest.search(i);
+        assert((i < NUM_FILTERED && i % 3 != 0 ? value != nullptr && *value == i : value == nullptr) && "The filtered table missed a record, or found a removed one");
+    }
+
     // display the hash table
     cout << "\n";
     hashTest.display();
@@ -79,30 +256,49 @@ int main()
 
     cout << "\nTEST CASES\n";
 
-    timer hashTime;
-
     cout << "\nProvide a list of celebrities with wide character variation...\n\n";
 
     const int NUM_CELEB = 30;
-    string celebList[NUM_CELEB] = {"Jake Gyllenhaal", "Zendaya", "Tom Holland", "Dax Shepard", "Winona Ryder", "Michael Fassbender", "Ice Cube",
+    static constexpr std::string_view celebList[NUM_CELEB] = {"Jake Gyllenhaal", "Zendaya", "Tom Holland", "Dax Shepard", "Winona Ryder", "Michael Fassbender", "Ice Cube",
                           "Björk", "Matthew McConaughey", "George Washington", "Julian Casablancas", "Taylor Swift", "Hugh Laurie", 
                           "Alanis Morissette", "Kyrie Irving", "Jason Mraz", "Henry VIII", "Dr. Phil", "Zach Galifianakis", "Adele", "Cardi B", 
                           "Alicia Keys", "Ellen DeGeneres", "Joaquin Phoenix", "Tony Leung", "Drake", "Robert Herjavec", "Idris Elba", "Javier Bardem", "Jay-Z"};
-    int birthList[] = {1980, 1996, 1996, 1975, 1971, 1977, 1969, 1965, 1969, 1732, 1978, 1989, 1959, 1974, 1992, 1977, 1491, 1950, 1969, 1988, 1992,
+    static constexpr int birthList[] = {1980, 1996, 1996, 1975, 1971, 1977, 1969, 1965, 1969, 1732, 1978, 1989, 1959, 1974, 1992, 1977, 1491, 1950, 1969, 1988, 1992,
                        1981, 1958, 1974, 1962, 1986, 1962, 1972, 1969, 1969};
 
-    CuckooHash hashCeleb;
+    CuckooHash<string, int> hashCeleb;
     for (int i = 0; i < NUM_CELEB; ++i)
     {
-        hashTime.restart();
-        hashCeleb.insert(celebList[i], birthList[i]);
-        hashTime.stop();
+        hashCeleb.insert(string(celebList[i]), birthList[i]);
 
-        cout << "insert " << hashCeleb.size() << " for key " << celebList[i] << ": " << hashTime.time() << " seconds\n";
+        cout << "insert " << hashCeleb.size() << " for key " << celebList[i] << "\n";
     }
     cout << "\n";
     hashCeleb.display();
     cout << "\n";
 
+    // the same records in a table built by the compiler, checked before the program ever runs
+    constexpr StaticCuckooHash<std::string_view, int, NUM_CELEB> staticCeleb(celebList, birthList, NUM_CELEB);
+    static_assert(staticCeleb.built() && staticCeleb.size() == NUM_CELEB, "The static table did not place every record");
+    static_assert(*staticCeleb.search("Zendaya") == 1996 && !staticCeleb.contains("Brad Pitt"), "An unexpected birth year was found");
+    for (int i = 0; i < NUM_CELEB; ++i)
+    {
+        assert(*staticCeleb.search(celebList[i]) == birthList[i] && "An unexpected birth year was found");
+    }
+    cout << "Built a static table of " << staticCeleb.size() << " records at compile time (seed " << std::hex << staticCeleb.seed() << std::dec << ")\n\n";
+
+    if (argc > 1)
+    {
+        cout << "Load the name - year records of " << argv[1] << "...\n\n";
+
+        CuckooHash<string, int> hashFile;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        cuckoo::LoadStats loaded = cuckoo::load_file(argv[1], hashFile);
+        std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+
+        cout << "loaded " << loaded.records << " records from " << loaded.lines << " lines (" << loaded.rejected << " rejected, "
+             << loaded.bytes << " bytes): " << seconds.count() << " seconds\n\n";
+    }
+
     //-------------------------------------------//
 }
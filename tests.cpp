@@ -0,0 +1,1099 @@
+/*
+    Data Structures
+    Project Hash: Cuckoo Hashing
+    Author: Anthony Lupica <arl127@uakron.edu> 2022
+
+    Randomized tests of the CuckooHash class template, with std::unordered_map as the reference.
+
+    For a range of slots per bucket and table counts, in both storage layouts (see cuckoo::Layout), with
+    stop-the-world and incremental resizing
+        differential   a random mix of inserts, upserts, insert_or_assign()s, removes and lookups, mostly
+                       batched (with keys repeated within a batch), over a small key space, so that
+                       duplicates and misses are frequent, is run on a CuckooHash and on a
+                       std::unordered_map. Every result, each record's cuckoo::Status, and now and then
+                       the whole contents, must agree.
+        load limit     random keys are inserted until the tables grow. They must reach the layout's maximum
+                       load (0.5 to 0.95, see cuckoo::maxLoadFactor()), so that growth comes from the load
+                       policy, never from the stash running over. Except with one slot in two tables (whose
+                       chains of evictions the stash exists for), nothing may be stashed by then either.
+        shrink         with a shrink threshold set by set_load_policy() (which must refuse invalid policies),
+                       removing 99% of the records must shrink the tables, and with no threshold
+                       shrink_to_fit() must; the remaining records must all still be found.
+
+    and on the counters of CuckooHash::stats()
+        metrics        after inserts (one of them a duplicate), growths, and lookups of present and absent
+                       keys, with and without a filter, and with incremental resizing, every counter must
+                       match them. The "tests_stats" target runs only this, compiled with CUCKOO_STATS;
+                       without it the counters must all stay zero.
+
+    and on a ShardedCuckooHash
+        sharded        several threads insert, overwrite, look up and remove interleaved keys at once, and
+                       a second table is bulk loaded with build(). Afterwards every shard may hold only keys
+                       that lookups route to it, no shard may be far fuller than the others, and both
+                       tables must agree with what the threads did.
+
+    and on a ConcurrentCuckooHash, of trivially copyable values (read without locks) and of strings
+        concurrent     writer threads insert, look up and remove interleaved keys while the tables grow,
+                       and a reader thread looks keys up meanwhile. Every result must match what the
+                       writers did. A key copy throwing std::bad_alloc while the tables grow must leave
+                       every record in place and the table usable. The "tests_tsan" target runs only these under ThreadSanitizer.
+
+    and on cuckoo::load_file()
+        loader         a file several LOAD_CHUNK_BYTES long, of LF and CRLF lines, blank lines, lines the
+                       parser rejects, repeated keys and one line longer than a chunk, is loaded with one
+                       and with several parsing threads. The LoadStats and the table's contents must match
+                       the file. A parser throwing part way must have its exception rethrown, leaving
+                       only records of the file in the table.
+
+    and on NUMA placement
+        replicated     a ReplicatedCuckooHash is published, and read back through a Reader of every node.
+                       A Reader sees a change of the primary only after the next publish().
+        allocator      tables over a NumaAllocator of each policy hold their records, and binding one to a
+                       node that does not exist throws std::bad_alloc, leaving the table as it was.
+
+    and on cuckoo::HugePageAllocator
+        huge pages     a HugePagePool hands a freed block to the next take() of its size, cleared, keeps at
+                       most HUGE_PAGE_POOL_BLOCKS, and is shared by copies of its allocator. A table over
+                       one allocator grows, shrinks and grows back, with the pool keeping its freed tables,
+                       and every record must be found after each step.
+
+    Keys and operations come from fixed seeds, so every run tests the same sequences. The program prints
+    each failed check and exits with 1 if there was any; ctest runs it as the "differential" test.
+*/
+
+#include "ConcurrentCuckooHash.hpp"
+#include "CuckooHash.hpp"
+#include "CuckooLoader.hpp"
+#include "HugePageAllocator.hpp"
+#include "NumaAllocator.hpp"
+#include "ReplicatedCuckooHash.hpp"
+#include "ShardedCuckooHash.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <initializer_list>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// operations of one differential run, and the keys they draw from
+const std::size_t DIFF_OPS = 200000;
+const std::uint64_t DIFF_KEYS = 5000;
+
+// most keys of one batched operation, enough to span several BATCH_GROUPs
+const std::size_t DIFF_BATCH = 40;
+
+// operations between two comparisons of the whole contents
+const std::size_t DIFF_FULL_CHECK = 10000;
+
+// growths each load limit run observes
+const int LIMIT_GROWTHS = 10;
+
+// threads of the sharded test, and the keys each of them writes
+const std::size_t SHARD_THREADS = 4;
+const std::uint64_t SHARD_KEYS = 20000;
+
+// threads of the concurrent test that write, and the keys each of them writes
+const std::size_t CONCURRENT_THREADS = 4;
+const std::uint64_t CONCURRENT_KEYS = 5000;
+
+// records of the NUMA tests, enough for tables well past NUMA_MIN_BYTES
+const std::uint64_t NUMA_KEYS = 20000;
+
+// records of the shrink test, and how many of them survive the removals (1 in SHRINK_KEEP)
+const std::uint64_t SHRINK_KEYS = 100000;
+const std::uint64_t SHRINK_KEEP = 100;
+
+// records of the loader test's file (about 20 bytes a line, so several LOAD_CHUNK_BYTES in all),
+// and the record whose line the throwing parser stops at
+const std::size_t LOADER_RECORDS = 600000;
+const std::size_t LOADER_THROW_AT = 400000;
+
+// records of the huge page test, enough for tables of several HUGE_PAGE_BYTES, and how many of them
+// survive the removals that shrink the table (1 in HUGE_KEEP)
+const std::uint64_t HUGE_KEYS = 300000;
+const std::uint64_t HUGE_KEEP = 100;
+
+// records of the metrics test, enough for several growths from the initial size
+const std::uint64_t METRICS_KEYS = 10000;
+
+// seeds of the runs of each layout
+const std::uint64_t SEEDS[] = { 1, 42, 1963 };
+
+static int failures = 0;
+
+// a key whose copies throw std::bad_alloc once copiesLeft reaches 0 (never while it is negative),
+// standing in for an allocation failing while a table grows
+struct FragileKey
+{
+    static int copiesLeft;
+
+    std::uint64_t id;
+
+    explicit FragileKey(std::uint64_t key) : id(key) {}
+    FragileKey(const FragileKey &other) : id(other.id)
+    {
+        if (copiesLeft == 0)
+        {
+            throw std::bad_alloc();
+        }
+        copiesLeft -= copiesLeft > 0;
+    }
+    FragileKey(FragileKey &&) noexcept = default;
+    FragileKey &operator=(const FragileKey &) = default;
+    bool operator==(const FragileKey &other) const { return id == other.id; }
+};
+
+int FragileKey::copiesLeft = -1;
+
+struct FragileKeyHash
+{
+    std::size_t operator()(const FragileKey &key) const { return static_cast<std::size_t>(key.id); }
+};
+
+/* expect()
+*
+*  reports a failed check of the named layout
+*/
+void expect(bool holds, const char *layout, const char *what)
+{
+    if (!holds)
+    {
+        std::printf("FAILED %s: %s\n", layout, what);
+        ++failures;
+    }
+}
+
+/* sameContents()
+*
+*  true if the table holds exactly the records of reference
+*/
+template <typename Table>
+bool sameContents(const Table &table, const std::unordered_map<std::uint64_t, std::uint64_t> &reference)
+{
+    bool same = table.size() == reference.size();
+    table.for_each([&](const std::uint64_t &key, const std::uint64_t &value)
+    {
+        auto found = reference.find(key);
+        same = same && found != reference.end() && found->second == value;
+    });
+
+    return same;
+}
+
+/* differential()
+*
+*  runs DIFF_OPS random operations on a table of the layout and on a std::unordered_map, and checks
+*  that every operation's result, and the contents every DIFF_FULL_CHECK operations, agree
+*/
+template <std::size_t SlotsPerBucket, std::size_t TableCount, cuckoo::Layout StorageLayout>
+void differential(const char *layout, std::uint64_t seed, bool incremental)
+{
+    CuckooHash<std::uint64_t, std::uint64_t, cuckoo::Hash<std::uint64_t>, cuckoo::Equal<std::uint64_t>, SlotsPerBucket, StorageLayout, TableCount> table;
+    table.set_incremental_resize(incremental);
+    std::unordered_map<std::uint64_t, std::uint64_t> reference;
+    std::mt19937_64 random(seed);
+
+    // the keys of a batched operation: half the time a single one, else up to DIFF_BATCH (across
+    // several BATCH_GROUPs), now and then with the first key repeated at the end
+    std::uint64_t keys[DIFF_BATCH];
+    std::uint64_t values[DIFF_BATCH];
+    cuckoo::Status statuses[DIFF_BATCH];
+    auto drawBatch = [&](std::uint64_t key)
+    {
+        std::size_t count = random() % 2 == 0 ? 1 : 1 + random() % DIFF_BATCH;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            keys[i] = i == 0 ? key : random() % DIFF_KEYS;
+            values[i] = random();
+        }
+        if (count > 1 && random() % 4 == 0)
+        {
+            keys[count - 1] = key;
+        }
+
+        return count;
+    };
+
+    for (std::size_t op = 1; op <= DIFF_OPS; ++op)
+    {
+        std::uint64_t key = random() % DIFF_KEYS;
+        std::uint64_t value = random();
+        cuckoo::Status status = cuckoo::Status::Failed;
+        switch (random() % 8)
+        {
+            case 0:
+            case 1:
+            {
+                // of two equal keys in a batch, the first is inserted and the second Exists
+                std::size_t count = drawBatch(key);
+                std::size_t added = table.insert_batch(keys, values, count, statuses);
+                std::size_t expectedAdded = 0;
+                bool same = true;
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    bool inserted = reference.emplace(keys[i], values[i]).second;
+                    expectedAdded += inserted;
+                    same = same && statuses[i] == (inserted ? cuckoo::Status::Inserted : cuckoo::Status::Exists);
+                }
+                expect(same && added == expectedAdded, layout, "insert_batch");
+                break;
+            }
+            case 2:
+            {
+                // of two equal keys in a batch, the second assigns its value over the first
+                std::size_t count = drawBatch(key);
+                std::size_t added = table.upsert_batch(keys, values, count, statuses);
+                std::size_t expectedAdded = 0;
+                bool same = true;
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    bool present = reference.count(keys[i]) != 0;
+                    reference[keys[i]] = values[i];
+                    expectedAdded += !present;
+                    same = same && statuses[i] == (present ? cuckoo::Status::Assigned : cuckoo::Status::Inserted);
+                }
+                expect(same && added == expectedAdded, layout, "upsert_batch");
+                break;
+            }
+            case 3:
+                status = table.insert_or_assign(key, value);
+                expect(status == (reference.count(key) != 0 ? cuckoo::Status::Assigned : cuckoo::Status::Inserted), layout, "insert_or_assign");
+                reference[key] = value;
+                break;
+            case 4:
+            case 5:
+            {
+                // of two equal keys in a batch, the first is removed and the second Missing
+                std::size_t count = drawBatch(key);
+                std::size_t removed = table.remove_batch(keys, count, statuses);
+                std::size_t expectedRemoved = 0;
+                bool same = true;
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    bool erased = reference.erase(keys[i]) != 0;
+                    expectedRemoved += erased;
+                    same = same && statuses[i] == (erased ? cuckoo::Status::Removed : cuckoo::Status::Missing);
+                }
+                expect(same && removed == expectedRemoved, layout, "remove_batch");
+                break;
+            }
+            case 6:
+            {
+                const std::uint64_t *found = table.search(key);
+                auto expected = reference.find(key);
+                expect(expected == reference.end() ? found == nullptr : found != nullptr && *found == expected->second, layout, "search");
+                break;
+            }
+            default:
+            {
+                // a batch of lookups, hits, misses and repeated keys mixed
+                std::size_t count = drawBatch(key);
+                const std::uint64_t *found[DIFF_BATCH];
+                bool contained[DIFF_BATCH];
+                std::size_t foundCount = table.search_batch(keys, count, found);
+                std::size_t containedCount = table.contains_batch(keys, count, contained);
+
+                std::size_t expectedCount = 0;
+                bool same = true;
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    auto expected = reference.find(keys[i]);
+                    bool present = expected != reference.end();
+                    expectedCount += present;
+                    same = same && contained[i] == present && (present ? found[i] != nullptr && *found[i] == expected->second : found[i] == nullptr);
+                }
+                expect(same && foundCount == expectedCount && containedCount == expectedCount, layout, "search_batch / contains_batch");
+                break;
+            }
+        }
+
+        if (op % DIFF_FULL_CHECK == 0)
+        {
+            expect(sameContents(table, reference), layout, "contents");
+        }
+    }
+}
+
+/* loadLimit()
+*
+*  inserts random keys into a table of the layout until it has grown LIMIT_GROWTHS times, and checks
+*  that each growth came at the layout's maximum load, with nothing stashed where the layout branches
+*/
+template <std::size_t SlotsPerBucket, std::size_t TableCount, cuckoo::Layout StorageLayout>
+void loadLimit(const char *layout, std::uint64_t seed)
+{
+    CuckooHash<std::uint64_t, std::uint64_t, cuckoo::Hash<std::uint64_t>, cuckoo::Equal<std::uint64_t>, SlotsPerBucket, StorageLayout, TableCount> table;
+    const double limit = cuckoo::maxLoadFactor(SlotsPerBucket, TableCount);
+    std::mt19937_64 random(seed);
+
+    for (int growths = 0; growths < LIMIT_GROWTHS;)
+    {
+        std::size_t buckets = table.capacity();
+        double load = table.load_factor();
+        std::size_t stashed = table.stats().stashed;
+
+        std::uint64_t key = random();
+        table.insert_batch(&key, &key, 1);
+        if (table.capacity() != buckets)
+        {
+            // the slot taken by one more record is the most the load may fall short of the limit by
+            expect(load + 1.0 / (TableCount * buckets * SlotsPerBucket) >= limit, layout, "the tables grew below the maximum load");
+            expect(stashed == 0 || SlotsPerBucket * (TableCount - 1) == 1, layout, "records were stashed below the maximum load");
+            ++growths;
+        }
+    }
+}
+
+/* testLayout()
+*
+*  every test of one layout, with each seed
+*/
+template <std::size_t SlotsPerBucket, std::size_t TableCount, cuckoo::Layout StorageLayout>
+void testLayout(const char *layout)
+{
+    for (std::uint64_t seed : SEEDS)
+    {
+        differential<SlotsPerBucket, TableCount, StorageLayout>(layout, seed, false);
+        differential<SlotsPerBucket, TableCount, StorageLayout>(layout, seed, true);
+        loadLimit<SlotsPerBucket, TableCount, StorageLayout>(layout, seed);
+    }
+    std::printf("%-28s done\n", layout);
+}
+
+/* shrink()
+*
+*  inserts SHRINK_KEYS records under a load policy, removes all but 1 in SHRINK_KEEP of them, and checks
+*  that the tables shrank (by the policy's threshold, or else by shrink_to_fit()) without losing a record
+*/
+void shrink(const char *layout, bool incremental, double shrinkLoadFactor)
+{
+    CuckooHash<std::uint64_t, std::uint64_t, cuckoo::Hash<std::uint64_t>, cuckoo::Equal<std::uint64_t>, 4> table;
+    table.set_incremental_resize(incremental);
+    const double limit = cuckoo::maxLoadFactor(4, 2);
+    const cuckoo::LoadPolicy policy = { limit, 2.0, shrinkLoadFactor };
+    expect(table.set_load_policy(policy), layout, "a valid load policy was refused");
+
+    // each invalid policy is refused, keeping the one set
+    const cuckoo::LoadPolicy INVALID[] = {
+        { 0.0, 2.0, 0.0 },           // no load at all
+        { 1.5, 2.0, 0.0 },           // more records than slots
+        { limit, 1.0, 0.0 },         // tables that do not grow
+        { limit, 2.0, -0.1 },        // a negative threshold
+        { limit, 2.0, limit / 2.0 }, // a threshold that shrinks the tables straight back into growing
+    };
+    for (const cuckoo::LoadPolicy &invalid : INVALID)
+    {
+        expect(!table.set_load_policy(invalid), layout, "an invalid load policy was accepted");
+        const cuckoo::LoadPolicy &kept = table.load_policy();
+        expect(kept.maxLoadFactor == policy.maxLoadFactor && kept.growthFactor == policy.growthFactor && kept.shrinkLoadFactor == policy.shrinkLoadFactor,
+               layout, "a refused load policy replaced the current one");
+    }
+
+    for (std::uint64_t key = 0; key < SHRINK_KEYS; ++key)
+    {
+        table.insert(key, key + 1);
+    }
+    std::size_t fullCapacity = table.capacity();
+    for (std::uint64_t key = 0; key < SHRINK_KEYS; ++key)
+    {
+        if (key % SHRINK_KEEP != 0)
+        {
+            table.remove(key);
+        }
+    }
+
+    if (shrinkLoadFactor == 0)
+    {
+        expect(table.capacity() == fullCapacity, layout, "the tables shrank with no shrink threshold");
+        table.shrink_to_fit();
+    }
+    expect(table.capacity() * 8 <= fullCapacity && table.load_factor() < limit, layout, "the tables did not shrink");
+    expect(table.size() == SHRINK_KEYS / SHRINK_KEEP, layout, "size");
+    for (std::uint64_t key = 0; key < SHRINK_KEYS; ++key)
+    {
+        const std::uint64_t *value = table.search(key);
+        expect(key % SHRINK_KEEP == 0 ? value != nullptr && *value == key + 1 : value == nullptr, layout, "a record was lost, or a removed one found, by shrinking");
+    }
+}
+
+/* shrinkPolicies()
+*
+*  shrink() with a threshold, and with none (shrink_to_fit()), with either kind of resize
+*/
+void shrinkPolicies()
+{
+    const char *layout = "shrink";
+    for (bool incremental : { false, true })
+    {
+        shrink(layout, incremental, cuckoo::maxLoadFactor(4, 2) / 4);
+        shrink(layout, incremental, 0.0);
+    }
+    std::printf("%-28s done\n", layout);
+}
+
+/* ThrowingParse
+*
+*  cuckoo::CsvParse, except that it throws on the line of record LOADER_THROW_AT
+*/
+struct ThrowingParse
+{
+    bool operator()(std::string_view line, std::string_view &key, int &value) const
+    {
+        if (line.find("record-" + std::to_string(LOADER_THROW_AT) + ",") != std::string_view::npos)
+        {
+            throw std::runtime_error("parse failure");
+        }
+
+        return cuckoo::CsvParse()(line, key, value);
+    }
+};
+
+/* loader()
+*
+*  writes a file of LOADER_RECORDS records, mixed with what load_file() must skip or reject, and checks
+*  what loading it with one and with three parsing threads (and with a throwing parser) reports and stores
+*/
+void loader()
+{
+    const char *layout = "loader";
+    const char *LOADER_PATH = "loaderTest.csv";
+
+    std::unordered_map<std::string, int> expected;
+    std::size_t lines = 0;
+    std::size_t rejected = 0;
+    {
+        std::ofstream file(LOADER_PATH, std::ios::binary | std::ios::trunc);
+        file << "name,year\r\n";
+        ++lines;
+        ++rejected;
+        for (std::size_t i = 0; i < LOADER_RECORDS; ++i)
+        {
+            std::string key = "record-" + std::to_string(i);
+            file << key << "," << i << (i % 2 == 0 ? "\r\n" : "\n");
+            expected.emplace(key, static_cast<int>(i));
+            ++lines;
+
+            if (i % 1000 == 0)
+            {
+                file << (i % 2000 == 0 ? "\r\n" : " \t\n");
+            }
+            if (i % 997 == 0)
+            {
+                file << "no separator " << i << "\n" << "record-x," << i << "x\r\n";
+                lines += 2;
+                rejected += 2;
+            }
+            if (i % 501 == 500)
+            {
+                // a repeated key keeps its first value
+                file << "record-" << i / 2 << "," << -1 << "\n";
+                ++lines;
+            }
+            if (i == LOADER_RECORDS / 3)
+            {
+                // longer than a whole chunk, so carried over in full
+                std::string longKey(cuckoo::LOAD_CHUNK_BYTES + 100, 'k');
+                file << longKey << ",7\n";
+                expected.emplace(longKey, 7);
+                ++lines;
+            }
+        }
+        file << "last-line,42";
+        expected.emplace("last-line", 42);
+        ++lines;
+    }
+    std::ifstream sized(LOADER_PATH, std::ios::binary | std::ios::ate);
+    std::size_t fileBytes = static_cast<std::size_t>(sized.tellg());
+    expect(fileBytes > 2 * cuckoo::LOAD_CHUNK_BYTES, layout, "the file is not several chunks long");
+
+    for (std::size_t workers : { 1, 3 })
+    {
+        CuckooHash<std::string, int> table;
+        cuckoo::LoadStats stats = cuckoo::load_file(LOADER_PATH, table, cuckoo::CsvParse(), workers);
+        expect(stats.bytes == fileBytes && stats.lines == lines && stats.rejected == rejected && stats.records == expected.size(), layout, "LoadStats");
+        expect(table.size() == expected.size(), layout, "size");
+        for (const auto &record : expected)
+        {
+            const int *value = table.search(record.first);
+            expect(value != nullptr && *value == record.second, layout, "a record of the file was not loaded, or with another value");
+        }
+    }
+
+    // the exception reaches the caller, once every stage has stopped, and what was inserted is from the file
+    CuckooHash<std::string, int> partial;
+    bool threw = false;
+    try
+    {
+        cuckoo::load_file(LOADER_PATH, partial, ThrowingParse(), 3);
+    }
+    catch (const std::runtime_error &)
+    {
+        threw = true;
+    }
+    expect(threw, layout, "the parser's exception was not rethrown");
+    expect(partial.size() < expected.size(), layout, "records past the failure were inserted");
+    partial.for_each([&](const std::string &key, const int &value)
+    {
+        auto found = expected.find(key);
+        expect(found != expected.end() && found->second == value, layout, "a record not in the file was inserted");
+    });
+
+    std::remove(LOADER_PATH);
+    std::printf("%-28s done\n", layout);
+}
+
+/* sharded()
+*
+*  runs SHARD_THREADS writers on one ShardedCuckooHash, each inserting its keys (interleaved with the
+*  other threads' keys), overwriting and removing some of them, and checks the shard routing and the contents
+*/
+void sharded()
+{
+    const char *layout = "sharded, 16 shards";
+    ShardedCuckooHash<std::uint64_t, std::uint64_t> table;
+    std::vector<std::thread> writers;
+    std::vector<int> threadFailures(SHARD_THREADS, 0);
+    for (std::size_t t = 0; t < SHARD_THREADS; ++t)
+    {
+        writers.emplace_back([&, t]
+        {
+            for (std::uint64_t i = 0; i < SHARD_KEYS; ++i)
+            {
+                std::uint64_t key = i * SHARD_THREADS + t;
+                threadFailures[t] += !table.insert(key, key);
+                threadFailures[t] += table.insert(key, 0);
+            }
+            for (std::uint64_t i = 0; i < SHARD_KEYS; ++i)
+            {
+                std::uint64_t key = i * SHARD_THREADS + t;
+                std::uint64_t value = 0;
+                threadFailures[t] += !table.search(key, value) || value != key;
+                if (i % 2 == 1)
+                {
+                    threadFailures[t] += !table.remove(key);
+                }
+                else if (i % 4 == 2)
+                {
+                    threadFailures[t] += table.insert_or_assign(key, key + 1) != cuckoo::Status::Assigned;
+                }
+            }
+        });
+    }
+    for (std::thread &writer : writers)
+    {
+        writer.join();
+    }
+    for (int failed : threadFailures)
+    {
+        expect(failed == 0, layout, "a concurrent operation returned an unexpected result");
+    }
+
+    // every key a shard holds is found by a lookup routed through the table (so lives in the shard it routes to)
+    std::size_t held = 0;
+    for (std::size_t s = 0; s < table.shard_count(); ++s)
+    {
+        std::vector<std::uint64_t> keys;
+        table.with_shard(s, [&](const CuckooHash<std::uint64_t, std::uint64_t> &shard)
+        {
+            shard.for_each([&](const std::uint64_t &key, const std::uint64_t &) { keys.push_back(key); });
+        });
+        for (std::uint64_t key : keys)
+        {
+            expect(table.contains(key), layout, "a shard holds a key lookups are not routed to");
+        }
+        held += keys.size();
+    }
+
+    std::uint64_t keyCount = SHARD_THREADS * SHARD_KEYS;
+    auto stats = table.stats();
+    expect(held == keyCount / 2 && table.size() == keyCount / 2, layout, "size");
+    expect(stats.smallestShard * 2 > held / table.shard_count() && stats.largestShard < 2 * held / table.shard_count(), layout, "the keys are not spread over the shards");
+    for (std::uint64_t key = 0; key < keyCount; ++key)
+    {
+        std::uint64_t value = 0;
+        bool found = table.search(key, value);
+        std::uint64_t i = key / SHARD_THREADS;
+        expect(i % 2 == 1 ? !found : found && value == (i % 4 == 2 ? key + 1 : key), layout, "contents");
+    }
+
+    // a bulk load routes its keys as single inserts do
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> records;
+    for (std::uint64_t key = 0; key < keyCount; ++key)
+    {
+        records.emplace_back(key, key);
+    }
+    ShardedCuckooHash<std::uint64_t, std::uint64_t> built;
+    built.set_thread_count(SHARD_THREADS);
+    expect(built.build(records.begin(), records.end()) == keyCount && built.size() == keyCount, layout, "build");
+    for (std::uint64_t key = 0; key < keyCount; ++key)
+    {
+        std::uint64_t value = 0;
+        expect(built.search(key, value) && value == key && built.remove(key), layout, "a built record was not found");
+    }
+    expect(built.size() == 0, layout, "records were left after removing every built one");
+
+    std::printf("%-28s done\n", layout);
+}
+
+/* concurrent()
+*
+*  writer threads insert, look up and remove interleaved keys of their own while the tables grow, and a
+*  reader thread looks keys up meanwhile. valueOf gives the one value a key may be stored with.
+*/
+template <typename Table, typename ValueOf>
+void concurrent(const char *layout, ValueOf valueOf)
+{
+    Table table;
+    std::vector<std::thread> threads;
+    std::vector<int> threadFailures(CONCURRENT_THREADS + 1, 0);
+    std::atomic<bool> writing(true);
+    std::uint64_t keyCount = CONCURRENT_THREADS * CONCURRENT_KEYS;
+
+    for (std::size_t t = 0; t < CONCURRENT_THREADS; ++t)
+    {
+        threads.emplace_back([&, t]
+        {
+            for (std::uint64_t i = 0; i < CONCURRENT_KEYS; ++i)
+            {
+                std::uint64_t key = i * CONCURRENT_THREADS + t;
+                threadFailures[t] += table.insert(key, valueOf(key)) != cuckoo::Status::Inserted;
+                threadFailures[t] += table.insert(key, valueOf(key + 1)) != cuckoo::Status::Exists;
+            }
+            for (std::uint64_t i = 0; i < CONCURRENT_KEYS; ++i)
+            {
+                std::uint64_t key = i * CONCURRENT_THREADS + t;
+                auto value = valueOf(key + 1);
+                threadFailures[t] += !table.search(key, value) || value != valueOf(key);
+                if (i % 2 == 1)
+                {
+                    threadFailures[t] += !table.remove(key) || table.contains(key);
+                }
+            }
+        });
+    }
+
+    // the reader may find a key or not, but never with a value it was not stored with
+    threads.emplace_back([&]
+    {
+        for (std::uint64_t key = 0; writing.load(std::memory_order_relaxed); key = (key + 7) % keyCount)
+        {
+            auto value = valueOf(key);
+            if (table.search(key, value))
+            {
+                threadFailures[CONCURRENT_THREADS] += value != valueOf(key);
+            }
+        }
+    });
+
+    for (std::size_t t = 0; t < CONCURRENT_THREADS; ++t)
+    {
+        threads[t].join();
+    }
+    writing.store(false, std::memory_order_relaxed);
+    threads.back().join();
+
+    for (int failed : threadFailures)
+    {
+        expect(failed == 0, layout, "a concurrent operation returned an unexpected result");
+    }
+    expect(table.size() == keyCount / 2, layout, "size");
+    for (std::uint64_t key = 0; key < keyCount; ++key)
+    {
+        auto value = valueOf(key + 1);
+        bool found = table.search(key, value);
+        expect(key / CONCURRENT_THREADS % 2 == 1 ? !found : found && value == valueOf(key), layout, "contents");
+    }
+
+    std::printf("%-28s done\n", layout);
+}
+
+/* growthThrows()
+*
+*  makes a key copy throw while a ConcurrentCuckooHash grows: the records must all still be found (from
+*  another thread too, which spins forever should a stripe be left locked), and the next insert must grow
+*/
+void growthThrows()
+{
+    const char *layout = "concurrent, growth throws";
+    ConcurrentCuckooHash<FragileKey, std::uint64_t, FragileKeyHash, std::equal_to<FragileKey>> table;
+
+    // each insert first copies its own record, then growth copies the table's; the second copy throws
+    bool threw = false;
+    std::uint64_t keyCount = 0;
+    std::size_t capacity = 0;
+    while (!threw && keyCount < CONCURRENT_KEYS)
+    {
+        capacity = table.capacity();
+        FragileKey::copiesLeft = 2;
+        try
+        {
+            expect(table.insert(FragileKey(keyCount), keyCount) == cuckoo::Status::Inserted, layout, "insert");
+            ++keyCount;
+        }
+        catch (const std::bad_alloc &)
+        {
+            threw = true;
+        }
+    }
+    FragileKey::copiesLeft = -1;
+
+    expect(threw && table.capacity() == capacity && table.size() == keyCount, layout, "growth did not throw, or changed the table");
+    std::thread reader([&]
+    {
+        for (std::uint64_t key = 0; key < keyCount; ++key)
+        {
+            std::uint64_t value = 0;
+            expect(table.search(FragileKey(key), value) && value == key, layout, "a record was lost by the failed growth");
+        }
+    });
+    reader.join();
+
+    std::size_t before = table.capacity();
+    expect(table.insert(FragileKey(keyCount), keyCount) == cuckoo::Status::Inserted && table.capacity() > before, layout, "the table did not grow after the failed growth");
+    for (std::uint64_t key = 0; key <= keyCount; ++key)
+    {
+        expect(table.contains(FragileKey(key)), layout, "a record was lost by the growth");
+    }
+
+    std::printf("%-28s done\n", layout);
+}
+
+/* concurrentTables()
+*
+*  runs concurrent() over a table read without locks, one of four slots, and one of strings read under the locks,
+*  then growthThrows()
+*/
+void concurrentTables()
+{
+    concurrent<ConcurrentCuckooHash<std::uint64_t, std::uint64_t>>("concurrent, optimistic", [](std::uint64_t key) { return key; });
+    concurrent<ConcurrentCuckooHash<std::uint64_t, std::uint64_t, cuckoo::Hash<std::uint64_t>, cuckoo::Equal<std::uint64_t>, 4>>("concurrent, 4 slots", [](std::uint64_t key) { return key; });
+    concurrent<ConcurrentCuckooHash<std::uint64_t, std::string>>("concurrent, locked strings", [](std::uint64_t key) { return std::to_string(key); });
+    growthThrows();
+}
+
+/* replicated()
+*
+*  publishes a ReplicatedCuckooHash, checks every node's replica through a Reader, and that an older
+*  Reader moves on to each new epoch
+*/
+void replicated()
+{
+    const char *layout = "replicated";
+    ReplicatedCuckooHash<std::uint64_t, std::uint64_t> table;
+    auto reader = table.reader();
+    for (std::uint64_t key = 0; key < NUMA_KEYS; ++key)
+    {
+        table.primary().insert(key, key);
+    }
+    expect(!reader.contains(0) && reader.epoch() == 0, layout, "a record was read before it was published");
+
+    expect(table.publish() == 1 && table.epoch() == 1, layout, "epoch");
+    for (std::size_t node = 0; node < table.node_count(); ++node)
+    {
+        auto nodeReader = table.reader(node);
+        for (std::uint64_t key = 0; key < NUMA_KEYS; ++key)
+        {
+            std::uint64_t value = 0;
+            expect(nodeReader.search(key, value) && value == key, layout, "a published record was not found");
+        }
+        expect(!nodeReader.contains(NUMA_KEYS) && nodeReader.numa_node() == node, layout, "a replica holds a record never inserted");
+    }
+
+    std::uint64_t value = 0;
+    expect(reader.search(NUMA_KEYS - 1, value) && value == NUMA_KEYS - 1 && reader.epoch() == 1, layout, "a Reader did not move to the new epoch");
+    table.primary().remove(0);
+    expect(reader.contains(0), layout, "a change was read before it was published");
+    table.publish();
+    expect(!reader.contains(0) && reader.epoch() == 2, layout, "a published remove was not read");
+
+    std::printf("%-28s done\n", layout);
+}
+
+/* numaAllocator()
+*
+*  fills a table over a NumaAllocator of each policy, and binds one to a node that does not exist
+*/
+void numaAllocator()
+{
+    const char *layout = "NUMA allocator";
+    using Table = CuckooHash<std::uint64_t, std::uint64_t, cuckoo::Hash<std::uint64_t>, cuckoo::Equal<std::uint64_t>, 4, cuckoo::Layout::AoS, 2,
+                             cuckoo::NumaAllocator<unsigned char>>;
+
+    // Preferred also on a node past NUMA_MAX_NODES, which leaves the memory unplaced
+    const std::pair<cuckoo::NumaPolicy, std::size_t> PLACEMENTS[] = {
+        { cuckoo::NumaPolicy::FirstTouch, 0 },
+        { cuckoo::NumaPolicy::Interleave, 0 },
+        { cuckoo::NumaPolicy::Preferred, 0 },
+        { cuckoo::NumaPolicy::Preferred, cuckoo::NUMA_MAX_NODES + 36 },
+    };
+    for (const auto &placement : PLACEMENTS)
+    {
+        cuckoo::NumaPolicy policy = placement.first;
+        Table table{ cuckoo::NumaAllocator<unsigned char>(policy, placement.second) };
+        for (std::uint64_t key = 0; key < NUMA_KEYS; ++key)
+        {
+            table.insert(key, key);
+        }
+        bool found = table.size() == NUMA_KEYS && table.get_allocator().placement() == policy && table.get_allocator().numa_node() == placement.second;
+        for (std::uint64_t key = 0; key < NUMA_KEYS; ++key)
+        {
+            const std::uint64_t *stored = table.search(key);
+            found = found && stored != nullptr && *stored == key;
+        }
+        expect(found, layout, "a record of a NUMA placed table was not found");
+    }
+
+#if defined(__linux__)
+    // binding to the first node that does not exist, and to one past NUMA_MAX_NODES (which the allocator
+    // keeps, rather than binding to another node instead)
+    for (std::size_t node : { cuckoo::numaNodeCount(), cuckoo::NUMA_MAX_NODES + 36 })
+    {
+        if (node >= cuckoo::NUMA_MAX_NODES && node == cuckoo::numaNodeCount())
+        {
+            continue;
+        }
+
+        Table bound{ cuckoo::NumaAllocator<unsigned char>(cuckoo::NumaPolicy::Bind, node) };
+        expect(bound.get_allocator().numa_node() == node, layout, "the allocator did not keep its node");
+        bound.insert(1, 1);
+        std::size_t buckets = bound.capacity();
+        bool thrown = false;
+        try
+        {
+            bound.reserve(NUMA_KEYS);
+        }
+        catch (const std::bad_alloc &)
+        {
+            thrown = true;
+        }
+        expect(thrown, layout, "binding to a node that does not exist did not fail the allocation");
+        expect(bound.capacity() == buckets && bound.size() == 1 && *bound.search(1) == 1, layout, "a failed allocation changed the table");
+    }
+#endif
+
+    std::printf("%-28s done\n", layout);
+}
+
+/* metrics()
+*
+*  checks the counters of stats() after operations whose counts are known. Built with CUCKOO_STATS (the
+*  "tests_stats" target), inserts must be timed and their placements counted, rehashes timed, and every
+*  lookup counted as a hit or a miss along with its probes. Built without, the counters must stay zero.
+*/
+void metrics()
+{
+    const char *layout = "metrics";
+    CuckooHash<std::uint64_t, std::uint64_t, cuckoo::Hash<std::uint64_t>, cuckoo::Equal<std::uint64_t>, 4> table;
+    for (std::uint64_t key = 0; key < METRICS_KEYS; ++key)
+    {
+        table.insert(key, key);
+    }
+    table.insert(0, 0);
+    for (std::uint64_t key = 0; key < 2 * METRICS_KEYS; ++key)
+    {
+        const std::uint64_t *stored = table.search(key);
+        expect(key < METRICS_KEYS ? stored != nullptr && *stored == key : stored == nullptr, layout, "a lookup went wrong");
+    }
+
+    auto stats = table.stats();
+    const cuckoo::Metrics &counted = stats.metrics;
+    std::size_t inserts = 0;
+    for (std::size_t latencyClass = 0; latencyClass < cuckoo::LATENCY_HISTOGRAM_BINS; ++latencyClass)
+    {
+        inserts += counted.insertLatency[latencyClass];
+    }
+    std::size_t placements = 0;
+    for (std::size_t moves = 0; moves < cuckoo::PATH_HISTOGRAM_BINS; ++moves)
+    {
+        placements += counted.pathLengths[moves];
+    }
+    expect(stats.instrumented == (CUCKOO_STATS != 0), layout, "instrumented");
+    if (!stats.instrumented)
+    {
+        expect(inserts == 0 && placements == 0 && counted.hits == 0 && counted.misses == 0 && counted.probes == 0 && counted.duplicates == 0
+               && counted.rehashes == 0 && counted.rehashNanoseconds == 0, layout, "an uninstrumented table counted");
+        std::printf("%-28s done\n", layout);
+
+        return;
+    }
+
+    // every insert() is timed, and every record placed without displacements or a stash
+    expect(inserts == METRICS_KEYS + 1 && counted.duplicates == 1, layout, "inserts were not all timed");
+    expect(placements == METRICS_KEYS && counted.pathLengths[0] > 0 && counted.pathFailures == 0, layout, "placements were not all counted");
+    expect(counted.rehashes > 0 && counted.longestRehashNanoseconds > 0 && counted.rehashNanoseconds >= counted.longestRehashNanoseconds,
+           layout, "the growths were not timed");
+
+    // a hit probes at least one table, a miss both
+    expect(counted.hits == METRICS_KEYS && counted.misses == METRICS_KEYS && counted.miss_ratio() == 0.5, layout, "lookups were not all counted");
+    expect(counted.probes >= counted.hits + 2 * counted.misses && counted.stashHits == 0 && counted.filterRejects == 0, layout, "probes");
+
+    // with a filter, misses mostly end there
+    table.set_filter(true);
+    for (std::uint64_t key = METRICS_KEYS; key < 2 * METRICS_KEYS; ++key)
+    {
+        expect(!table.contains(key), layout, "a lookup went wrong");
+    }
+    cuckoo::Metrics filtered = table.stats().metrics;
+    expect(filtered.misses == 2 * METRICS_KEYS && filtered.filterRejects > METRICS_KEYS / 2, layout, "the filter's rejections were not counted");
+
+    // an incremental table starts migrations instead of rehashing
+    CuckooHash<std::uint64_t, std::uint64_t, cuckoo::Hash<std::uint64_t>, cuckoo::Equal<std::uint64_t>, 4> incremental;
+    incremental.set_incremental_resize(true);
+    for (std::uint64_t key = 0; key < METRICS_KEYS; ++key)
+    {
+        incremental.insert(key, key);
+    }
+    expect(incremental.stats().metrics.migrations > 0, layout, "migrations were not counted");
+
+    std::printf("%-28s done\n", layout);
+}
+
+/* hugePages()
+*
+*  takes and gives blocks of a HugePagePool directly, then grows, shrinks and grows back a table over one
+*  HugePageAllocator, whose freed tables the pool keeps
+*/
+void hugePages()
+{
+    const char *layout = "huge pages";
+
+    // a freed block is taken again by the next take() of its size, cleared
+    cuckoo::HugePagePool pool;
+    unsigned char *block = static_cast<unsigned char *>(pool.take(cuckoo::HUGE_PAGE_BYTES + 1));
+    std::memset(block, 0xAB, 2 * cuckoo::HUGE_PAGE_BYTES);
+    pool.give(block, cuckoo::HUGE_PAGE_BYTES + 1);
+    expect(pool.pooled_bytes() == 2 * cuckoo::HUGE_PAGE_BYTES, layout, "a freed block was not kept");
+    unsigned char *reused = static_cast<unsigned char *>(pool.take(2 * cuckoo::HUGE_PAGE_BYTES));
+    bool cleared = true;
+    for (std::size_t byte = 0; byte < 2 * cuckoo::HUGE_PAGE_BYTES; ++byte)
+    {
+        cleared = cleared && reused[byte] == 0;
+    }
+    expect(reused == block && pool.pooled_bytes() == 0, layout, "a kept block was not reused");
+    expect(cleared, layout, "a reused block was not cleared");
+    pool.give(reused, 2 * cuckoo::HUGE_PAGE_BYTES);
+
+    // one block past HUGE_PAGE_POOL_BLOCKS evicts the longest-kept one, the reused block
+    std::vector<void *> blocks;
+    for (std::size_t i = 0; i < cuckoo::HUGE_PAGE_POOL_BLOCKS; ++i)
+    {
+        blocks.push_back(pool.take(cuckoo::HUGE_PAGE_BYTES));
+    }
+    for (void *memory : blocks)
+    {
+        pool.give(memory, cuckoo::HUGE_PAGE_BYTES);
+    }
+    expect(pool.pooled_bytes() == cuckoo::HUGE_PAGE_POOL_BLOCKS * cuckoo::HUGE_PAGE_BYTES, layout, "the longest-kept block was not evicted");
+    pool.trim();
+    expect(pool.pooled_bytes() == 0, layout, "trim() kept a block");
+
+    // copies of an allocator, rebound or not, share its pool
+    cuckoo::HugePageAllocator<unsigned char> allocator;
+    cuckoo::HugePageAllocator<std::uint64_t> copy(allocator);
+    copy.deallocate(copy.allocate(cuckoo::HUGE_PAGE_BYTES / sizeof(std::uint64_t)), cuckoo::HUGE_PAGE_BYTES / sizeof(std::uint64_t));
+    expect(copy == allocator && allocator.memory_pool()->pooled_bytes() == cuckoo::HUGE_PAGE_BYTES, layout, "a copy of the allocator has a pool of its own");
+    allocator.memory_pool()->trim();
+
+    // a table that grows keeps its old tables in the pool. Shrinking takes some of them back (cleared, or
+    // records removed before would reappear), and keeps the large tables; growing back loses no record
+    using Table = CuckooHash<std::uint64_t, std::uint64_t, cuckoo::Hash<std::uint64_t>, cuckoo::Equal<std::uint64_t>, 4, cuckoo::Layout::AoS, 2,
+                             cuckoo::HugePageAllocator<unsigned char>>;
+    Table table{ allocator };
+    auto fill = [&]()
+    {
+        for (std::uint64_t key = 0; key < HUGE_KEYS; ++key)
+        {
+            if (!table.contains(key))
+            {
+                table.insert(key, key);
+            }
+        }
+    };
+    auto allFound = [&](std::uint64_t keep)
+    {
+        bool found = table.size() == (HUGE_KEYS + keep - 1) / keep;
+        for (std::uint64_t key = 0; key < HUGE_KEYS; ++key)
+        {
+            const std::uint64_t *stored = table.search(key);
+            found = found && (key % keep == 0 ? stored != nullptr && *stored == key : stored == nullptr);
+        }
+
+        return found;
+    };
+
+    fill();
+    std::size_t grown = allocator.memory_pool()->pooled_bytes();
+    expect(grown > 0, layout, "the old tables were not kept");
+    expect(allFound(1), layout, "a record of a table over huge pages was not found");
+
+    std::size_t buckets = table.capacity();
+    for (std::uint64_t key = 0; key < HUGE_KEYS; ++key)
+    {
+        if (key % HUGE_KEEP != 0)
+        {
+            table.remove(key);
+        }
+    }
+    std::size_t shrunk = allocator.memory_pool()->pooled_bytes();
+    expect(table.capacity() < buckets && shrunk > grown, layout, "the shrink did not give its tables to the pool");
+    expect(allFound(HUGE_KEEP), layout, "a record was lost by the shrink");
+
+    fill();
+    expect(table.capacity() >= buckets && allFound(1), layout, "a record was lost growing back over reused blocks");
+    allocator.memory_pool()->trim();
+    expect(allocator.memory_pool()->pooled_bytes() == 0 && allFound(1), layout, "trim() took a block in use");
+
+    std::printf("%-28s done\n", layout);
+}
+
+int main(int argc, char *argv[])
+{
+    // the ThreadSanitizer build runs only the tests of threads sharing one table
+    if (argc > 1 && std::strcmp(argv[1], "--concurrent") == 0)
+    {
+        concurrentTables();
+        std::printf("%d failed checks\n", failures);
+
+        return failures == 0 ? 0 : 1;
+    }
+
+    // the CUCKOO_STATS build runs only the test of the counters
+    if (argc > 1 && std::strcmp(argv[1], "--stats") == 0)
+    {
+        metrics();
+        std::printf("%d failed checks\n", failures);
+
+        return failures == 0 ? 0 : 1;
+    }
+
+    testLayout<1, 2, cuckoo::Layout::AoS>("1 slot, 2 tables (0.5)");
+    testLayout<2, 2, cuckoo::Layout::AoS>("2 slots, 2 tables (0.8)");
+    testLayout<4, 2, cuckoo::Layout::AoS>("4 slots, 2 tables (0.9)");
+    testLayout<1, 3, cuckoo::Layout::AoS>("1 slot, 3 tables (0.85)");
+    testLayout<1, 4, cuckoo::Layout::AoS>("1 slot, 4 tables (0.9)");
+    testLayout<2, 3, cuckoo::Layout::AoS>("2 slots, 3 tables (0.95)");
+    testLayout<4, 4, cuckoo::Layout::AoS>("4 slots, 4 tables (0.95)");
+    testLayout<1, 2, cuckoo::Layout::SoA>("SoA, 1 slot, 2 tables");
+    testLayout<4, 2, cuckoo::Layout::SoA>("SoA, 4 slots, 2 tables");
+    testLayout<2, 3, cuckoo::Layout::SoA>("SoA, 2 slots, 3 tables");
+    shrinkPolicies();
+    metrics();
+    loader();
+    sharded();
+    concurrentTables();
+    replicated();
+    numaAllocator();
+    hugePages();
+
+    std::printf("%d failed checks\n", failures);
+
+    return failures == 0 ? 0 : 1;
+}